@@ -0,0 +1,36 @@
+#pragma once
+#include "cli/value.h"
+#include "psl/array.hpp"
+#include "psl/ustring.hpp"
+
+namespace assembler {
+/// \brief runs a manifest of jobs, concurrently wherever their dependencies allow it.
+/// \details every line of the manifest describes a single job in the same style as the meta library, f.e.
+/// `[NAME=textures][COMMAND=-g -m -i "source/textures/*" -o "data/textures/*.meta" -t "TEXTURE_META"]`
+/// `[NAME=library][DEPENDS=textures, shaders*][COMMAND=-g -l -d "library" -r "data"]`
+/// where `COMMAND` is written identical to what would be entered in the interactive prompt (including `|` chains),
+/// and `DEPENDS` is an optional comma separated list of job names that need to finish first. A name ending in `*`
+/// depends on all jobs starting with that prefix. Empty lines, and lines starting with `#` are ignored.
+/// A job starts as soon as all its dependencies succeeded, when one of them failed the job is skipped.
+/// \note every worker thread owns its own set of generators, so no state is shared between concurrent jobs.
+class batch {
+	template <typename T>
+	using cli_value = psl::cli::value<T>;
+
+  public:
+	psl::cli::pack pack();
+
+  private:
+	struct job_t {
+		psl::string name {};
+		psl::string command {};
+		psl::array<psl::string> depends {};
+	};
+
+	bool load(psl::string const& manifest);
+	bool resolve(psl::array<psl::array<size_t>>& dependents, psl::array<size_t>& pending) const;
+	void on_run(psl::cli::pack& pack);
+
+	psl::array<job_t> m_Jobs {};
+};
+}	 // namespace assembler
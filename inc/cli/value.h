@@ -422,12 +422,13 @@ class pack final {
 	};
 
   public:
-	void parse(psl::array<psl::string_view> commands) {
+	// returns false when the commands could not be parsed, failed validation, or contained unknown commands
+	bool parse(psl::array<psl::string_view> commands) {
 		reset();
 		if(commands.size() == 0 ||
 		   std::all_of(std::begin(commands), std::end(commands), [](auto const& command) { return command.empty(); })) {
 			assembler::log->warn("no commands entered...");
-			return;
+			return false;
 		}
 
 		for(auto const& view : commands) {
@@ -443,7 +444,7 @@ class pack final {
 				if(token_offset == psl::string_view::npos) {
 					// error out
 					assembler::log->error("ERROR: opened a delimiter (\"), but did not close it again.");
-					return;
+					return false;
 				}
 				occupied_ranges.emplace_back(std::pair {begin_token, token_offset});
 			}
@@ -477,13 +478,13 @@ class pack final {
 					assembler::log->error(
 					  "ERROR: a short command cannot have multiple characters, please check: - {}",
 					  psl::to_string8_t(psl::string_view(view.data() + cmd_start, cmd_end - cmd_start)));
-					return;
+					return false;
 				}
 				if(!is_long_command && cmd_end - cmd_start == 0) {
 					assembler::log->error(
 					  "ERROR: a short command supplied, but no character behind it, please check the "
 					  "free floating '-'");
-					return;
+					return false;
 				}
 				if(cmd_end != cmd_start) {
 					commands.emplace_back(command {psl::string_view(view.data() + cmd_start, cmd_end - cmd_start),
@@ -493,20 +494,25 @@ class pack final {
 			}
 
 			if(!validate(commands, true))
-				return;
+				return false;
 
 			std::queue<pack*> processed_packs;
 			bool error = false;
-			parse(std::begin(commands), std::end(commands), processed_packs, error);
-
+			if(auto const it = parse(std::begin(commands), std::end(commands), processed_packs, error);
+			   it != std::end(commands)) {
+				assembler::log->error("ERROR: invalid command detected. the command '{}' was not found.",
+									  psl::to_string8_t(it->cmd));
+				return false;
+			}
 			if(error) {
-				return;
+				return false;
 			}
 			while(processed_packs.size() > 0) {
 				processed_packs.front()->operator()();
 				processed_packs.pop();
 			}
 		}
+		return true;
 	}
 
 	void callback(std::function<void(pack&)> fn) { m_Callback = fn; }
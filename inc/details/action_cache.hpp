@@ -0,0 +1,42 @@
+#pragma once
+#include "psl/array.hpp"
+#include "psl/ustring.hpp"
+#include <cstdint>
+
+namespace assembler {
+/// \brief content addressed, on-disk cache of generator outputs.
+/// \details every action (a single invocation of a generator on a single input) is identified by a key derived from
+/// the generator name, the input bytes, the generator options and `action_cache::version`. When the key is already
+/// present in the cache directory, the outputs are copied over instead of being regenerated.
+/// The directory can be shared between machines (f.e. a network drive used by CI and developers), entries are written
+/// to a temporary location first and then moved into place so concurrent writers never observe partial entries.
+/// \note meta files are never restored as-is, the UID of the existing meta file at the destination is kept (or a new
+/// one is generated), as the cached UID belongs to whoever populated the cache.
+class action_cache {
+  public:
+	/// \brief bump this whenever the output of any generator changes for the same input and options, so that stale
+	/// entries from older versions of the assembler are not restored.
+	static constexpr uint64_t version {10};
+
+	action_cache() = default;
+	action_cache(psl::string directory);
+
+	/// \brief an empty directory disables the cache.
+	void directory(psl::string directory);
+	bool enabled() const noexcept { return !m_Directory.empty(); }
+
+	static uint64_t key(psl::string8::view generator, psl::string8::view input, psl::string8::view options) noexcept;
+
+	/// \brief restores all outputs of the given key relative to `output` (the output path without extension).
+	/// \returns false when the key was not present in the cache, or when it failed to restore.
+	bool restore(uint64_t key, psl::string const& output) const;
+
+	/// \brief stores the files `output + suffix` for the given key, suffixes whose file does not exist are ignored.
+	bool store(uint64_t key, psl::string const& output, psl::array<psl::string> const& suffixes) const;
+
+  private:
+	psl::string entry(uint64_t key) const;
+
+	psl::string m_Directory {};
+};
+}	 // namespace assembler
@@ -0,0 +1,114 @@
+#pragma once
+#include "psl/array.hpp"
+#include "psl/ustring.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace tools {
+/// \brief how the components of a `geometry_stream_t` are stored.
+/// \details the decoded value of a component is `normalized * scale + offset`, where normalized is the component
+/// converted to a float (mapped to [0, 1] for unorm, and [-1, 1] for snorm formats).
+enum class vertex_format_t : uint8_t {
+	float32 = 0,
+	unorm16 = 1,
+	snorm16_octahedral = 2,	   // two components that hold an octahedral encoded unit vector
+	float16 = 3,
+	unorm8	= 4,
+};
+
+/// \brief size in bytes of a single component of the format.
+constexpr size_t component_size(vertex_format_t format) noexcept {
+	switch(format) {
+	case vertex_format_t::float32:
+		return 4;
+	case vertex_format_t::unorm16:
+	case vertex_format_t::snorm16_octahedral:
+	case vertex_format_t::float16:
+		return 2;
+	case vertex_format_t::unorm8:
+		return 1;
+	}
+	return 0;
+}
+
+/// \brief how the streams of a `geometry_file_t` are distributed over vertex buffers.
+enum class vertex_layout_t : uint8_t {
+	separate	= 0,	// every stream in its own buffer
+	interleaved = 1,	// all streams interleaved in a single buffer
+	hybrid		= 2,	// the position in its own buffer, the other streams interleaved in a second buffer
+};
+
+/// \brief where the attribute of a stream is located in the vertex buffers.
+struct stream_binding_t {
+	uint32_t buffer {0};
+	uint32_t offset {0};	// in bytes, from the start of the vertex
+};
+
+struct buffer_layout_t {
+	psl::array<stream_binding_t> bindings {};	 // one for every stream
+	psl::array<uint32_t> strides {};			 // one for every buffer
+};
+
+/// \brief places streams of the given strides (in bytes) in vertex buffers, the first stream is the position.
+/// \details every attribute starts at a multiple of `alignment`, and the strides are padded to a multiple of it, as
+/// most APIs require 4 byte aligned attributes.
+buffer_layout_t layout_streams(std::span<size_t const> strides, vertex_layout_t layout, size_t alignment);
+
+struct geometry_stream_t {
+	psl::string name {};	// name of the matching `core::data::geometry_t` stream, f.e. "POSITION"
+	vertex_format_t format {vertex_format_t::float32};
+	uint8_t components {0};
+	std::array<float, 4> scale {1.0f, 1.0f, 1.0f, 1.0f};
+	std::array<float, 4> offset {0.0f, 0.0f, 0.0f, 0.0f};
+	psl::array<uint8_t> data {};
+
+	size_t stride() const noexcept { return component_size(format) * components; }
+	size_t vertex_count() const noexcept { return (stride() == 0) ? 0 : data.size() / stride(); }
+};
+
+/// \brief geometry as the assembler writes it in the `pgb` format, as an alternative to `core::data::geometry_t`
+/// that can be memory mapped and uploaded as-is, and that can store the streams in other formats than 32bit floats.
+/// \details all values are stored little-endian, offsets are in bytes from the start of the file. The layout is
+/// - header: "PGB\0", version, stream count, buffer count, vertex count, index count, index size, index offset,
+///   index data size, string table offset, string table size, file size (all uint32)
+/// - stream table, per stream: name offset (into the string table), name size, attribute offset in the vertex (all
+///   uint32), buffer (uint32), format (uint8), components (uint8), 2 bytes padding, scale (4 floats), offset (4 floats)
+/// - buffer table, per buffer: data offset, data size, stride, 4 bytes padding (all uint32)
+/// - the string table, the names of the streams
+/// - the buffers, and then the indices (16bit when every index fits, leaving 0xFFFF free for primitive restart,
+///   32bit otherwise), each starting at a multiple of `blob_alignment`
+struct geometry_file_t {
+	static constexpr uint32_t version {3};
+	static constexpr size_t blob_alignment {64};
+
+	psl::array<geometry_stream_t> streams {};	 // the first stream is the position
+	psl::array<uint32_t> indices {};
+	vertex_layout_t layout {vertex_layout_t::separate};
+	size_t alignment {4};
+
+	/// \brief size in bytes of the indices as they are stored.
+	uint32_t index_size() const noexcept;
+
+	psl::string8_t encode() const;
+};
+
+/// \brief stores the values as-is, `values` holds `components` floats per vertex.
+geometry_stream_t encode_float(psl::string_view name, std::span<float const> values, uint8_t components);
+
+/// \brief stores three component positions as 16bit values normalized to the bounds of the positions, padded to four
+/// components so every vertex stays 4 byte aligned.
+geometry_stream_t quantize_position(psl::string_view name, std::span<float const> values);
+
+/// \brief stores three component unit vectors (normals, tangents, ...) as two octahedral encoded 16bit snorm values.
+geometry_stream_t quantize_direction(psl::string_view name, std::span<float const> values);
+
+/// \brief stores two component texture coordinates as half floats.
+geometry_stream_t quantize_uv(psl::string_view name, std::span<float const> values);
+
+/// \brief stores four component colors as 8bit unorm values.
+geometry_stream_t quantize_color(psl::string_view name, std::span<float const> values);
+
+/// \brief converts to a half float, rounding to the nearest value.
+uint16_t to_half(float value) noexcept;
+}	 // namespace tools
@@ -0,0 +1,97 @@
+#pragma once
+#include "psl/ustring.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace assembler {
+namespace _internal {
+	inline constexpr uint64_t hash_prime_1 {0x9E3779B185EBCA87ull};
+	inline constexpr uint64_t hash_prime_2 {0xC2B2AE3D27D4EB4Full};
+	inline constexpr uint64_t hash_prime_3 {0x165667B19E3779F9ull};
+	inline constexpr uint64_t hash_prime_4 {0x85EBCA77C2B2AE63ull};
+	inline constexpr uint64_t hash_prime_5 {0x27D4EB2F165667C5ull};
+
+	constexpr uint64_t rotl(uint64_t value, int bits) noexcept {
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	constexpr uint64_t hash_round(uint64_t accumulator, uint64_t input) noexcept {
+		accumulator += input * hash_prime_2;
+		accumulator = rotl(accumulator, 31);
+		return accumulator * hash_prime_1;
+	}
+
+	constexpr uint64_t hash_merge(uint64_t accumulator, uint64_t value) noexcept {
+		accumulator ^= hash_round(0, value);
+		return accumulator * hash_prime_1 + hash_prime_4;
+	}
+
+	inline uint64_t read64(char const* data) noexcept {
+		uint64_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t read32(char const* data) noexcept {
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+}	 // namespace _internal
+
+/// \brief fast, non-cryptographic 64bit content hash (xxHash64).
+/// \details used to detect content changes (shader sources, cache keys, output deduplication), it should never be
+/// used where collisions could be provoked on purpose.
+inline uint64_t hash64(void const* source, size_t size, uint64_t seed = 0) noexcept {
+	using namespace _internal;
+	auto data		= static_cast<char const*>(source);
+	auto const* end = data + size;
+	uint64_t result;
+
+	if(size >= 32) {
+		uint64_t v1 = seed + hash_prime_1 + hash_prime_2;
+		uint64_t v2 = seed + hash_prime_2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - hash_prime_1;
+		for(auto const* limit = end - 32; data <= limit; data += 32) {
+			v1 = hash_round(v1, read64(data));
+			v2 = hash_round(v2, read64(data + 8));
+			v3 = hash_round(v3, read64(data + 16));
+			v4 = hash_round(v4, read64(data + 24));
+		}
+		result = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		result = hash_merge(result, v1);
+		result = hash_merge(result, v2);
+		result = hash_merge(result, v3);
+		result = hash_merge(result, v4);
+	} else {
+		result = seed + hash_prime_5;
+	}
+
+	result += static_cast<uint64_t>(size);
+	for(; data + 8 <= end; data += 8) {
+		result ^= hash_round(0, read64(data));
+		result = rotl(result, 27) * hash_prime_1 + hash_prime_4;
+	}
+	if(data + 4 <= end) {
+		result ^= static_cast<uint64_t>(read32(data)) * hash_prime_1;
+		result = rotl(result, 23) * hash_prime_2 + hash_prime_3;
+		data += 4;
+	}
+	for(; data < end; ++data) {
+		result ^= static_cast<uint64_t>(static_cast<uint8_t>(*data)) * hash_prime_5;
+		result = rotl(result, 11) * hash_prime_1;
+	}
+
+	result ^= result >> 33;
+	result *= hash_prime_2;
+	result ^= result >> 29;
+	result *= hash_prime_3;
+	result ^= result >> 32;
+	return result;
+}
+
+inline uint64_t hash64(psl::string_view source, uint64_t seed = 0) noexcept {
+	return hash64(source.data(), source.size(), seed);
+}
+}	 // namespace assembler
@@ -0,0 +1,135 @@
+#pragma once
+#include "psl/array.hpp"
+#include "psl/math/math.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace tools {
+/// \brief result of simulating the post-transform vertex cache over an index buffer.
+struct vertex_cache_statistics_t {
+	size_t misses {0};
+	size_t triangles {0};
+	size_t vertices {0};	// unique vertices referenced by the indices
+
+	/// \brief average cache miss ratio, transformed vertices per triangle (lower is better, 0.5 is the ideal).
+	float acmr() const noexcept { return (triangles == 0) ? 0.0f : static_cast<float>(misses) / triangles; }
+	/// \brief average transformed to vertex ratio, how often each vertex gets transformed (lower is better, 1.0 is the
+	/// ideal).
+	float atvr() const noexcept { return (vertices == 0) ? 0.0f : static_cast<float>(misses) / vertices; }
+};
+
+/// \brief result of simulating the memory fetches the vertex shader inputs cause.
+struct vertex_fetch_statistics_t {
+	size_t hits {0};
+	size_t misses {0};
+
+	/// \brief ratio of the cache line accesses that were already cached (higher is better).
+	float hit_ratio() const noexcept {
+		return (hits + misses == 0) ? 0.0f : static_cast<float>(hits) / static_cast<float>(hits + misses);
+	}
+};
+
+/// \brief simulates a FIFO post-transform vertex cache of `cache_size` entries, which is how most hardware behaves.
+vertex_cache_statistics_t
+analyze_vertex_cache(std::span<uint32_t const> indices, size_t vertex_count, size_t cache_size = 16);
+
+/// \brief simulates the cache lines that get fetched for the given vertex streams, every stream is a separate buffer
+/// with the given stride (in bytes), such as the `core::vertex_stream_t`s of a `core::data::geometry_t`.
+vertex_fetch_statistics_t analyze_vertex_fetch(std::span<uint32_t const> indices,
+											   size_t vertex_count,
+											   std::span<size_t const> strides,
+											   size_t cache_line	= 64,
+											   size_t cache_lines	= 1024);
+
+/// \brief reorders the triangles so consecutive triangles reuse the vertices that are still in the post-transform
+/// cache.
+/// \details implementation of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", the cache is modelled as an LRU
+/// cache of 32 entries, which gives good results for most cache sizes and replacement policies.
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count);
+
+/// \brief reorders clusters of triangles so that the triangles facing outwards are drawn first, reducing overdraw.
+/// \details the indices should already be optimized for the vertex cache. They get split into clusters at the points
+/// where the cache gets flushed, and at the points where the local ACMR stays within `threshold` of the cluster's
+/// ACMR. The order within the clusters is kept, so the vertex cache efficiency only degrades by at most `threshold`.
+/// See Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+void optimize_overdraw(std::span<uint32_t> indices, std::span<psl::vec3 const> positions, float threshold = 1.05f);
+
+/// \brief remaps the vertices into the order in which the indices first use them, so the vertex fetches are as close
+/// together as possible.
+/// \details the indices are rewritten to the new vertex order, vertices that are never referenced are dropped.
+/// \returns for every new vertex the index of the vertex it was before, all vertex streams should be reordered with it.
+psl::array<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count);
+
+/// \brief splits the triangles into consecutive runs that each reference at most `max_vertices` unique vertices.
+/// \details the triangles are not reordered, so the runs keep the locality of a vertex cache optimized order.
+/// \returns the offset (in indices) at which every run starts, followed by the size of `indices`.
+psl::array<size_t> split_by_vertex_count(std::span<uint32_t const> indices, size_t vertex_count, size_t max_vertices);
+
+/// \brief a small cluster of triangles, used to cull parts of a mesh on the GPU.
+/// \details a meshlet can be skipped when the camera is inside the normal cone's backside, which is the case when
+/// `dot(normalize(cone_apex - camera_position), cone_axis) >= cone_cutoff`. A `cone_cutoff` of 1 means the meshlet can
+/// never be backface culled.
+struct meshlet_t {
+	uint32_t vertex_offset {0};		 // into `meshlets_t::vertices`
+	uint32_t vertex_count {0};
+	uint32_t triangle_offset {0};	 // into `meshlets_t::triangles`, in triangles
+	uint32_t triangle_count {0};
+
+	std::array<float, 3> center {};
+	float radius {0.0f};
+	std::array<float, 3> cone_apex {};
+	std::array<float, 3> cone_axis {};
+	float cone_cutoff {1.0f};
+};
+
+struct meshlets_t {
+	psl::array<meshlet_t> meshlets {};
+	psl::array<uint32_t> vertices {};	 // the vertices of the meshlets, indices into the vertices of the mesh
+	psl::array<uint8_t> triangles {};	 // three indices per triangle, local to the vertices of its meshlet
+};
+
+/// \brief partitions the triangles into meshlets of at most `max_vertices` (up to 256) vertices and `max_triangles`
+/// triangles, in the order of the indices.
+/// \details the indices should be optimized for the vertex cache, so consecutive triangles share their vertices.
+/// \param positions three floats for every vertex.
+meshlets_t build_meshlets(std::span<uint32_t const> indices,
+						  std::span<float const> positions,
+						  size_t max_vertices,
+						  size_t max_triangles);
+
+/// \brief axis aligned bounds and bounding sphere of a set of vertices.
+struct bounding_volume_t {
+	std::array<float, 3> min {};
+	std::array<float, 3> max {};
+	std::array<float, 3> center {};
+	float radius {0.0f};
+};
+
+/// \brief computes the bounds of the vertices, and a bounding sphere using Ritter's algorithm ("An Efficient Bounding
+/// Sphere"), or the sphere around the bounds when that one is smaller.
+/// \param positions three floats for every vertex.
+bounding_volume_t compute_bounding_volume(std::span<float const> positions);
+
+/// \brief simplifies the mesh by collapsing edges in the order of their quadric error (Garland and Heckbert, "Surface
+/// Simplification Using Quadric Error Metrics"), until `target_index_count` or `target_error` is reached.
+/// \details the simplified triangles reference the original vertices, no new vertices are created. Vertices on the
+/// border of the mesh are never moved. Vertices that share their position with other vertices (such as UV seams and
+/// hard normals) are only collapsed together, along the seam, so the simplified mesh doesn't open up cracks.
+/// `attributes` contains `attribute_count` floats for every vertex, the squared difference of the attributes is added
+/// to the cost of a collapse, scale the attributes to weigh them against the geometric error.
+/// \param[out] destination receives the indices, needs to be as large as `indices`.
+/// The geometric error of a collapse is the root mean square distance (weighted by area) of the merged vertex to the
+/// planes of the original triangles around both vertices.
+/// \param target_error the maximum geometric error, relative to the largest dimension of the mesh's bounds.
+/// \param[out] result_error the largest geometric error of all collapses, relative to the largest dimension.
+/// \returns the amount of indices that were written to `destination`.
+size_t simplify(std::span<uint32_t> destination,
+				std::span<uint32_t const> indices,
+				std::span<psl::vec3 const> positions,
+				std::span<float const> attributes,
+				size_t attribute_count,
+				size_t target_index_count,
+				float target_error,
+				float& result_error);
+}	 // namespace tools
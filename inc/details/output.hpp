@@ -0,0 +1,22 @@
+#pragma once
+#include "psl/ustring.hpp"
+#include <cstddef>
+
+namespace assembler {
+/// \brief writes `content` to `path`, unless the file at `path` already holds exactly those bytes.
+/// \details leaving identical files untouched preserves their write time, so that everything downstream (such as the
+/// TIME and METATIME fields of the meta library) does not consider them modified.
+/// \returns false when the file had to be written, but the write failed.
+bool write_if_changed(psl::string const& path, psl::string8::view content);
+
+struct write_statistics_t {
+	size_t written {0};
+	size_t unchanged {0};
+};
+
+/// \brief totals of all `write_if_changed` calls since the start of the application.
+write_statistics_t write_statistics() noexcept;
+
+/// \brief logs how many writes were avoided since the `since` snapshot was taken.
+void log_write_statistics(write_statistics_t const& since);
+}	 // namespace assembler
@@ -0,0 +1,125 @@
+#pragma once
+#include "psl/array.hpp"
+#include "psl/ustring.hpp"
+#include "stdafx.h"
+
+#include "spdlog/details/null_mutex.h"
+#include "spdlog/sinks/base_sink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace assembler {
+/// \brief spdlog sink that holds on to all messages of a single task.
+/// \details used by the parallel helpers so that the output of concurrently running tasks can be replayed in
+/// submission order, keeping the log identical to a serial run.
+class buffered_sink final : public spdlog::sinks::base_sink<spdlog::details::null_mutex> {
+  public:
+	void replay(spdlog::logger& target) {
+		for(auto const& [level, message] : m_Messages) {
+			target.log(level, "{}", message);
+		}
+		m_Messages.clear();
+	}
+
+	psl::array<std::pair<spdlog::level::level_enum, psl::string8_t>> const& messages() const noexcept {
+		return m_Messages;
+	}
+
+  protected:
+	void sink_it_(spdlog::details::log_msg const& msg) override {
+		m_Messages.emplace_back(msg.level, psl::string8_t(msg.payload.data(), msg.payload.size()));
+	}
+	void flush_() override {}
+
+  private:
+	psl::array<std::pair<spdlog::level::level_enum, psl::string8_t>> m_Messages {};
+};
+
+/// \brief resolves the user facing job count, where `0` means "all available cores".
+inline size_t resolve_jobs(size_t jobs) noexcept {
+	return (jobs == 0) ? std::max<size_t>(1u, std::thread::hardware_concurrency()) : jobs;
+}
+
+/// \brief invokes `fn(index)` for every index in [0, count) using up to `jobs` worker threads.
+/// \details every task logs into its own buffer (see `assembler::log`), which gets replayed on the calling thread in
+/// index order as soon as the task, and all tasks before it, have finished.
+/// An exception thrown by a task doesn't stop the other tasks, the first one that was thrown gets rethrown on the
+/// calling thread once all tasks have finished.
+/// \note when only one job is requested (or needed) the tasks run in order on the calling thread.
+template <typename Fn>
+void parallel_for(size_t count, size_t jobs, Fn&& fn) {
+	std::exception_ptr exception {};
+	jobs = std::min(resolve_jobs(jobs), count);
+	if(jobs <= 1) {
+		for(size_t i = 0; i < count; ++i) {
+			try {
+				std::invoke(fn, i);
+			} catch(...) {
+				if(!exception)
+					exception = std::current_exception();
+			}
+		}
+		if(exception)
+			std::rethrow_exception(exception);
+		return;
+	}
+
+	struct task_t {
+		std::shared_ptr<buffered_sink> sink {};
+		bool done {false};
+	};
+
+	auto parent = log;
+	psl::array<task_t> tasks(count);
+	std::mutex mutex;
+	std::condition_variable condition;
+	std::atomic<size_t> next {0};
+
+	auto worker = [&]() {
+		for(size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+			auto sink = std::make_shared<buffered_sink>();
+			log		  = std::make_shared<spdlog::logger>("", sink);
+			log->set_level(parent->level());
+			std::exception_ptr error {};
+			try {
+				std::invoke(fn, i);
+			} catch(...) {
+				error = std::current_exception();
+			}
+			log.reset();
+			{
+				std::lock_guard lock {mutex};
+				if(error && !exception)
+					exception = error;
+				tasks[i].sink = std::move(sink);
+				tasks[i].done = true;
+			}
+			condition.notify_all();
+		}
+	};
+
+	psl::array<std::thread> threads {};
+	threads.reserve(jobs);
+	for(size_t i = 0; i < jobs; ++i) threads.emplace_back(worker);
+
+	for(size_t i = 0; i < count; ++i) {
+		std::shared_ptr<buffered_sink> sink {};
+		{
+			std::unique_lock lock {mutex};
+			condition.wait(lock, [&tasks, i]() { return tasks[i].done; });
+			sink = std::move(tasks[i].sink);
+		}
+		sink->replay(*parent);
+	}
+
+	for(auto& thread : threads) thread.join();
+	if(exception)
+		std::rethrow_exception(exception);
+}
+}	 // namespace assembler
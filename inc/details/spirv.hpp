@@ -2,6 +2,7 @@
 #include <core/meta/shader.hpp>
 #include <optional>
 #include <psl/ustring.hpp>
+#include <vector>
 
 namespace tools {
 namespace _internal {
@@ -9,12 +10,35 @@ namespace _internal {
 		glslang_manager_t();
 		~glslang_manager_t();
 	};
-	extern glslang_manager_t glslang_manager;
+	/// \brief initializes the glslang process on first use, so commands that never compile shaders don't pay for it.
+	glslang_manager_t& glslang_manager();
 
 }	 // namespace _internal
 enum class shader_stage_t : uint8_t { unknown = 100, vert = 0, tesc = 1, tese = 2, geom = 3, frag = 4, comp = 5 };
 inline constexpr psl::string_view shader_stage_str[] {"vert", ("tesc"), ("tese"), ("geom"), ("frag"), ("comp")};
 
+/// \brief which spirv-opt recipe should be ran on the generated SPIR-V
+enum class optimization_t : uint8_t { none = 0, performance = 1, size = 2 };
+
+/// \brief SPIR-V module stored as 32bit words, so it can be handed to glslang, spirv-opt, SPIRV-Cross and tint as-is.
+/// \note this is a std::vector instead of a psl::array as that is the type tint and spirv-opt consume.
+struct spirv_t {
+	std::vector<uint32_t> words {};
+
+	uint32_t* data() noexcept { return words.data(); }
+	uint32_t const* data() const noexcept { return words.data(); }
+	// size in words
+	size_t size() const noexcept { return words.size(); }
+	bool empty() const noexcept { return words.empty(); }
+
+	/// \brief view of the module as raw bytes, for writing to disk or hashing
+	psl::string8::view bytes() const noexcept {
+		return {reinterpret_cast<char const*>(words.data()), words.size() * sizeof(uint32_t)};
+	}
+
+	bool operator==(spirv_t const& other) const noexcept = default;
+};
+
 struct glsl_compile_result_t {
 	constexpr glsl_compile_result_t() = default;
 	constexpr glsl_compile_result_t(bool value) : success(value) {};
@@ -31,13 +55,22 @@ struct glsl_compile_result_t {
 		psl::array<core::meta::shader::descriptor> descriptors {};
 		core::gfx::shader_stage stage {core::gfx::shader_stage {0}};
 	} shader {};
-	psl::string8_t spirv {};
+	spirv_t spirv {};
 	psl::string8_t gles {};
+	psl::string8_t wgsl {};	   // only generated when AS_ENABLE_WGSL is set
 	bool success {false};
+
+	struct statistics_t {
+		size_t instructions {0};
+		size_t bytes {0};
+	};
+	// only filled in when an optimization recipe was ran, describes the SPIR-V before and after optimizing
+	statistics_t unoptimized {};
+	statistics_t optimized {};
 };
 
 glsl_compile_result_t glsl_compile(psl::string_view source,
 								   shader_stage_t type,
-								   bool optimize					  = false,
+								   optimization_t optimize			  = optimization_t::none,
 								   std::optional<size_t> gles_version = std::nullopt);
 }	 // namespace tools
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "core/gles/conversion.hpp"
 #include "core/meta/shader.hpp"
 #include "core/meta/texture.hpp"
+#include "details/action_cache.hpp"
+#include "details/output.hpp"
 #include "psl/array_view.hpp"
 #include "psl/library.hpp"
 #include "psl/meta.hpp"
@@ -481,15 +483,7 @@ class meta {
 	};
 
   public:
-	meta() {
-		if(psl::utility::platform::file::exists("metamapping.txt")) {
-			mapping_table table;
-			psl::serialization::serializer s;
-			s.deserialize<psl::serialization::decode_from_format>(table, "metamapping.txt");
-			m_FileMaps = table.mappings();
-			m_EnvMaps  = table.environments();
-		}
-	}
+	meta() = default;
 
 	cli_pack meta_pack() {
 		return cli_pack {
@@ -505,7 +499,13 @@ class meta {
 		  cli_value<bool> {"update",
 						   "update is a specialization of force, where everything will be regenerated except the UID",
 						   {"update", "u"},
-						   false}
+						   false},
+		  cli_value<psl::string> {"cache",
+								  "directory of the action cache, metas of previously seen inputs are restored from "
+								  "here (empty to disable)",
+								  {"cache"},
+								  "",
+								  true}
 
 		};
 	}
@@ -524,12 +524,27 @@ class meta {
 	}
 
   private:
+	/// \brief loads the mapping table the first time it's needed, so commands that don't use it don't pay for it
+	void load_mappings() {
+		if(m_MappingsLoaded)
+			return;
+		m_MappingsLoaded = true;
+		if(psl::utility::platform::file::exists("metamapping.txt")) {
+			mapping_table table;
+			psl::serialization::serializer s;
+			s.deserialize<psl::serialization::decode_from_format>(table, "metamapping.txt");
+			m_FileMaps = table.mappings();
+			m_EnvMaps  = table.environments();
+		}
+	}
+
 	void on_library_generate(cli_pack& pack) {
 		// --generate -l -d "C:\Projects\github\example_data\library" -r "C:\Projects\github\example_data\data"
 		auto lib_dir  = pack["directory"]->as<psl::string>().get();
 		auto lib_name = pack["name"]->as<psl::string>().get();
 		auto res_dir  = pack["resource"]->as<psl::string>().get();
 		auto clean	  = pack["clean"]->as<bool>().get();
+		load_mappings();
 
 		size_t relative_position = 0u;
 
@@ -658,7 +673,7 @@ class meta {
 			}
 		}
 
-		psl::utility::platform::file::write(lib_dir + lib_name, psl::string_view(content.data(), content.size() - 1));
+		assembler::write_if_changed(lib_dir + lib_name, psl::string8::view(content.data(), content.size() - 1));
 		assembler::log->info("wrote out a new meta library at: '{}'", psl::to_string8_t(lib_dir + lib_name));
 	}
 
@@ -673,6 +688,9 @@ class meta {
 		auto recursive_search = pack["recursive"]->as<bool>().get();
 		auto force_regenerate = pack["force"]->as<bool>().get();
 		auto update			  = pack["update"]->as<bool>().get();
+		m_ActionCache.directory(pack["cache"]->as<psl::string>().get());
+		auto const writes = assembler::write_statistics();
+		load_mappings();
 
 		if(update)
 			force_regenerate = update;
@@ -717,6 +735,19 @@ class meta {
 			   it != psl::serialization::accessor::polymorphic_data().end()) {
 				psl::meta::file* target = (psl::meta::file*)((*it->second->factory)());
 
+				// the whole input and the output location are part of the key, every meta carries its own UID so
+				// metas of different files should never be restored from the same entry
+				auto const data = psl::utility::platform::file::read(input).value();
+
+				// a forced regeneration without update should hand out a new UID, which restoring would not do
+				auto const cache_key = m_ActionCache.key(
+				  "meta", psl::to_string8_t(data), psl::to_string8_t(meta_t) + "|" + output.platform());
+				if((!force_regenerate || update) && m_ActionCache.restore(cache_key, output.platform())) {
+					delete(target);
+					assembler::log->info("restored a {0} file to {1} from the cache", meta_t, output.platform());
+					continue;
+				}
+
 				psl::UID uid = psl::UID::generate();
 				psl::serialization::serializer s;
 
@@ -729,9 +760,6 @@ class meta {
 
 				switch(id) {
 				case psl::utility::crc64("TEXTURE_META"): {
-					auto data = psl::utility::platform::file::read(
-								  input, std::max(utility::ktx::header_size(), utility::dds::header_size()))
-								  .value();
 					auto view = psl::array_view<std::byte>((std::byte*)data.data(), data.size());
 					if(utility::ktx::is_ktx(view)) {
 						auto header =
@@ -767,8 +795,10 @@ class meta {
 				cont.add_value(metaNode.get(), "UID", psl::utility::to_string(uid));
 
 
-				psl::utility::platform::file::write(output, psl::from_string8_t(cont.to_string()));
+				assembler::write_if_changed(output.platform(), cont.to_string());
 				assembler::log->info("wrote a {0} file to {1} from {2}", meta_t, output.platform(), input.platform());
+				if(m_ActionCache.enabled())
+					m_ActionCache.store(cache_key, output.platform(), {""});
 			} else {
 				psl::utility::terminal::set_color(psl::utility::terminal::color::RED);
 				assembler::log->error("error: could not deduce the polymorphic type from the given key '{}'", meta_t);
@@ -778,10 +808,13 @@ class meta {
 				continue;
 			}
 		}
+		assembler::log_write_statistics(writes);
 	}
 
 	std::unordered_map<psl::string, psl::string> m_FileMaps;
 	std::unordered_map<psl::string, psl::array<psl::string>> m_EnvMaps;
+	bool m_MappingsLoaded {false};
+	assembler::action_cache m_ActionCache {};
 };
 }	 // namespace assembler::generators
 // const uint64_t core::meta::texture::polymorphic_identity{serialization::register_polymorphic<core::meta::texture>()};
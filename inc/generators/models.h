@@ -1,5 +1,13 @@
 ﻿#pragma once
 #include "cli/value.h"
+#include "details/action_cache.hpp"
+#include "details/geometry_file.hpp"
+#include <array>
+#include <vector>
+
+namespace Assimp {
+class Importer;
+}
 
 namespace assembler::generators {
 class models {
@@ -15,9 +23,39 @@ class models {
 
 	psl::cli::pack& pack() { return m_Pack; }
 
+	// options of a single invocation, shared by all files and meshes it imports
+	struct settings_t {
+		unsigned int flags {0};
+		std::array<uint8_t, 3> axis {};
+		psl::string axis_name {};
+		bool reorder {false};
+		std::vector<float> lods {};	   // triangle ratios of the LODs
+		float lod_error {0.01f};
+		bool quantize {false};
+		bool mappable {false};	   // write `tools::geometry_file_t` instead of `core::data::geometry_t`
+		tools::vertex_layout_t layout {tools::vertex_layout_t::separate};
+		size_t alignment {4};	 // of the interleaved attributes and strides
+		bool split {false};	   // split meshes into parts that fit 16bit indices
+		bool meshlets {false};
+		size_t meshlet_vertices {64};
+		size_t meshlet_triangles {124};
+		bool binary {false};
+		size_t jobs {1};	// amount of meshes of a single file that are converted concurrently
+
+		// `tools::geometry_file_t` (pgb) is written instead of `core::data::geometry_t` (pgf)
+		bool geometry_file() const noexcept {
+			return mappable || quantize || layout != tools::vertex_layout_t::separate;
+		}
+	};
+
   private:
 	void on_invoke(psl::cli::pack& pack);
+	bool import_file(Assimp::Importer& importer,
+					 psl::string const& input_file,
+					 psl::string const& output_file,
+					 settings_t const& settings) const;
 
 	psl::cli::pack m_Pack;
+	assembler::action_cache m_ActionCache {};
 };
 }	 // namespace assembler::generators
@@ -1,8 +1,11 @@
 ﻿#pragma once
 #include "cli/value.h"
+#include "details/action_cache.hpp"
+#include "details/spirv.hpp"
 #include "psl/string_utils.hpp"
 #include "psl/terminal_utils.hpp"
 #include "psl/timer.hpp"
+#include <mutex>
 #include <set>
 
 namespace assembler {
@@ -14,66 +17,38 @@ class shader {
 	using cli_value = psl::cli::value<T>;
 
   public:
+	/// \brief location of an `#include` directive in the content of a file
+	struct include_t {
+		psl::string path;
+		size_t offset;	  // start of the directive
+		size_t length;	  // length of the directive, up to (but excluding) the end of the line
+	};
+
 	struct file_data {
 		uint64_t last_modified;
-		psl::string content;
+		uint64_t hash;	  // content hash, only set when content hashing is enabled
+		psl::string content;	// unmodified content of the file, includes are resolved during expansion
 		psl::string filename;
-		std::vector<std::pair<psl::string, size_t>> includes;
+		std::vector<include_t> includes;
 		uint8_t type;
+		uint64_t validated {0};	   // epoch in which the file and its dependencies were last validated
 	};
 
-  private:
-	std::unordered_map<psl::string, size_t> m_KnownTypes {{("bool"), 1},
-														  {("int"), 4},
-														  {("uint"), 4},
-														  {("float"), 4},
-														  {("double"), 8},
-														  {("sampler"), 0},
-														  {("sampler2D"), 0},
-														  {("sampler3D"), 0},
-														  {("samplerCube"), 0}};
-
-	std::unordered_map<psl::string, size_t> m_TypeToFormat {{("vec4"), 72},
-															{("mat4"), 72},
-															{("vec3"), 69},
-															{("mat3"), 69},
-															{("vec2"), 66},
-															{("mat2"), 66}};
-
-	std::unordered_map<psl::string, size_t> m_DescriptorType {{("ubo"), 6}, {("ssbo"), 7}, {("combined_sampler"), 1}};
-
-  public:
-	shader() {
-		std::unordered_map<psl::string, size_t> vectoral_types {
-		  {("b"), 1}, {("i"), 4}, {("u"), 4}, {(""), 4}, {("d"), 8}};
-		for(size_t i = 2; i <= 4; ++i) {
-			for(auto const& vType : vectoral_types) {
-				psl::string fulltype   = vType.first + ("vec") + psl::from_string8_t(psl::utility::to_string(i));
-				size_t size			   = vType.second * i;
-				m_KnownTypes[fulltype] = size;
-			}
-		}
-
-		vectoral_types = std::unordered_map<psl::string, size_t> {{(""), 4}, {("d"), 8}};
-		for(size_t i = 2; i <= 4; ++i) {
-			for(auto const& vType : vectoral_types) {
-				psl::string fulltype   = vType.first + ("mat") + psl::from_string8_t(psl::utility::to_string(i));
-				size_t size			   = vType.second * i * i;
-				m_KnownTypes[fulltype] = size;
-			}
-		}
+	/// \brief a single permutation of a shader, as described in the variant manifest
+	struct variant_t {
+		psl::string name;
+		psl::array<psl::string> defines;	// either `NAME` or `NAME=VALUE`
+	};
 
-		for(size_t n = 2; n <= 4; ++n) {
-			for(size_t m = 2; m <= 4; ++m) {
-				for(auto const& vType : vectoral_types) {
-					psl::string fulltype = vType.first + ("mat") + psl::from_string8_t(psl::utility::to_string(n)) + ("x") +
-										   psl::from_string8_t(psl::utility::to_string(m));
-					size_t size			   = vType.second * n * m;
-					m_KnownTypes[fulltype] = size;
-				}
-			}
-		}
-	}
+	/// \brief node of the persisted include graph
+	/// \details `dependents` are the reverse edges, i.e. every shader that (transitively) includes this file.
+	/// `options` is only set for shaders that were compiled, and describes the settings they were compiled with.
+	struct dependency_node_t {
+		uint64_t last_modified {0};
+		uint64_t hash {0};
+		psl::string options {};
+		std::set<psl::string> dependents {};
+	};
 
 	psl::cli::pack pack() {
 		return psl::cli::pack {
@@ -81,11 +56,17 @@ class shader {
 		  cli_value<psl::string> {"input", "location of the input file", {"input", "i"}, "", false},
 		  cli_value<psl::string> {"output", "location where to place the file", {"output", "o"}, "", true},
 		  cli_value<bool> {"overwrite",
-						   "should the output file be overwritten if it already exists?",
+						   "should the output file be overwritten if it already exists? this rebuilds shaders that "
+						   "incremental builds consider up to date",
 						   {"overwrite", "f", "force"},
-						   true,
+						   false,
 						   true},
 		  cli_value<bool> {"optimize", "should we optimize the output", {"optimize", "O"}, false, true},
+		  cli_value<bool> {"optimize size",
+						   "optimize the output for size instead of performance",
+						   {"optimize_size", "Os"},
+						   false,
+						   true},
 		  cli_value<bool> {"compiled glsl",
 						   "should we instead print the complete constructed GLSL (with includes etc..)?",
 						   {"glsl"},
@@ -97,24 +78,93 @@ class shader {
 						   false,
 						   true},
 		  cli_value<std::vector<psl::string>> {
-			"types", "graphics types to support", {"types"}, {"vulkan", "gles"}, true, {{"vulkan", "gles"}}}};
+			"types", "graphics types to support", {"types"}, {"vulkan", "gles"}, true, {{"vulkan", "gles"}}},
+		  cli_value<bool> {"incremental",
+						   "only compile shaders whose source, includes or settings changed since the last run",
+						   {"incremental"},
+						   false,
+						   true},
+		  cli_value<psl::string> {"dependencies",
+								  "location of the persisted include graph used by incremental builds",
+								  {"dependencies"},
+								  "shader_dependencies.txt",
+								  true},
+		  cli_value<bool> {"hash",
+						   "compare the content hash of files whose write time changed before treating them as modified",
+						   {"hash"},
+						   false,
+						   true},
+		  cli_value<psl::string> {"variants",
+								  "manifest of define sets (one `name: DEFINE DEFINE=VALUE` per line) every input is "
+								  "compiled with",
+								  {"variants"},
+								  "",
+								  true},
+		  cli_value<size_t> {"jobs",
+							 "amount of shaders that are compiled concurrently, 0 uses all available cores",
+							 {"jobs", "j"},
+							 1,
+							 true},
+		  cli_value<psl::string> {"cache",
+								  "directory of the action cache, outputs of previously seen inputs and settings are "
+								  "restored from here instead of being compiled (empty to disable)",
+								  {"cache"},
+								  "",
+								  true}};
 	}
 
   private:
 	bool parse(file_data& data);
 	bool cache_file(psl::string const& file);
+	/// \brief amount of files a validation of `file` checks, the file itself and everything it (transitively) includes.
+	size_t include_tree_size(psl::string const& file) const;
+
+	void segments(file_data const& fdata,
+				  std::set<psl::string_view>& includes,
+				  psl::array<psl::string_view>& result) const;
+	psl::string expand(file_data const& fdata) const;
 
-	psl::string construct(file_data const& fdata, std::set<psl::string_view>& includes) const;
+	static std::unordered_map<psl::string, dependency_node_t> read_dependencies(psl::string const& file);
+	void load_dependencies(psl::string const& file);
+	void save_dependencies(psl::string const& file) const;
+	std::set<psl::string> outdated_dependencies();
+	void record_dependencies(psl::string const& file, psl::string const& options);
 
 	bool generate(assembler::pathstring ifile,
 				  assembler::pathstring ofile,
 				  bool compiled_glsl,
-				  bool optimize,
+				  tools::optimization_t optimize,
 				  psl::array<psl::string> types);
+	bool generate_variants(psl::string_view content,
+						   tools::shader_stage_t type,
+						   tools::optimization_t optimize,
+						   std::optional<size_t> gles_version,
+						   psl::string const& output_file);
+	bool write(tools::glsl_compile_result_t const& result, psl::string const& output_file);
+	void log_messages(tools::glsl_compile_result_t const& result) const;
+	/// \brief checks that every output the current options produce for `output_file` is present.
+	bool outputs_exist(psl::string const& output_file, bool gles) const;
+	bool load_variants(psl::string const& file);
 	void on_generate(psl::cli::pack& pack);
 
 	std::unordered_map<psl::string, file_data> m_Cache;	   // Caches the files read. Note that the filepath
 														   // will always be Unix style regardless of input
+	mutable std::recursive_mutex m_CacheMutex;			   // guards m_Cache when shaders are generated concurrently
+	std::unordered_map<psl::string, dependency_node_t> m_Dependencies;	  // include graph of the last known builds
+
+	// every on_generate invocation starts a new epoch, files are validated against the disk at most once per epoch
+	uint64_t m_Epoch {0};
+	struct {
+		size_t skipped {0};	   // validations that were skipped as the file was already validated in this epoch
+		size_t stats {0};	   // stat calls the skipped validations would have done (the file and its include tree)
+		size_t rehashed {0};   // files with a new write time, but an unchanged content hash
+	} m_ValidationStats;
 	bool m_Verbose {false};
+	bool m_Hash {false};
+
+	psl::array<variant_t> m_Variants {};
+	uint64_t m_VariantsHash {0};
+	assembler::action_cache m_ActionCache {};
+	size_t m_VariantJobs {1};
 };
 }	 // namespace assembler::generators
@@ -0,0 +1,29 @@
+#pragma once
+#include "cli/value.h"
+#include "psl/ustring.hpp"
+#include <optional>
+
+namespace assembler {
+/// \brief long lived compile server, keeps the generators (and so their caches) alive in between requests.
+/// \details requests are read from stdin, each one is its size in bytes (as text) followed by a newline, and then the
+/// command itself, written identically to what would be entered in the interactive prompt
+/// (f.e. `generate shader -i foo.vert -o bar`).
+/// every request gets answered on stdout using the same framing, where the payload is a serialized `RESPONSE`
+/// containing if the request succeeded, how long it took (in microseconds), and all the messages it logged.
+/// the server stops when stdin is closed, or when it receives the `exit` command.
+/// \note while the server runs, stdout is reserved for the responses, anything else written to it (through iostreams
+/// or C stdio) is redirected to stderr.
+class server {
+  public:
+	server(psl::cli::pack& root) : m_Root(root) {};
+
+	void run();
+
+  private:
+	std::optional<psl::string8_t> read_request(std::istream& input) const;
+	psl::string8_t handle(psl::string8::view request);
+
+	psl::cli::pack& m_Root;
+	size_t m_Requests {0};
+};
+}	 // namespace assembler
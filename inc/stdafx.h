@@ -15,7 +15,8 @@
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 namespace assembler {
-extern std::shared_ptr<spdlog::logger> log;
+// thread local so that worker threads can redirect their output into a per-task buffer (see details/parallel.hpp)
+extern thread_local std::shared_ptr<spdlog::logger> log;
 }
 
 // TODO: reference additional headers your program requires here
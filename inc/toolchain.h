@@ -0,0 +1,33 @@
+#pragma once
+#include "cli/value.h"
+#include <memory>
+
+namespace assembler::generators {
+class shader;
+class models;
+class meta;
+}	 // namespace assembler::generators
+
+namespace assembler {
+/// \brief owns an instance of every generator, together with the command pack that drives them.
+/// \details generators keep state in between invocations (caches, settings, ..), so every thread that runs commands
+/// concurrently needs its own toolchain.
+class toolchain {
+  public:
+	toolchain();
+	~toolchain();
+
+	toolchain(toolchain const&)			   = delete;
+	toolchain(toolchain&&)				   = delete;
+	toolchain& operator=(toolchain const&) = delete;
+	toolchain& operator=(toolchain&&)	   = delete;
+
+	psl::cli::pack& generators() noexcept { return m_Generators; }
+
+  private:
+	std::unique_ptr<generators::shader> m_Shader;
+	std::unique_ptr<generators::models> m_Models;
+	std::unique_ptr<generators::meta> m_Meta;
+	psl::cli::pack m_Generators;
+};
+}	 // namespace assembler
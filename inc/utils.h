@@ -35,6 +35,14 @@ class pathstring {
 	psl::string8_t path {};
 };
 
+// strips leading and trailing spaces, tabs and carriage returns
+inline psl::string_view trim(psl::string_view value) noexcept {
+	auto const begin = value.find_first_not_of(" \t\r");
+	if(begin == psl::string_view::npos)
+		return {};
+	return value.substr(begin, value.find_last_not_of(" \t\r") - begin + 1);
+}
+
 inline psl::array<std::pair<pathstring, pathstring>> get_files(pathstring input, pathstring output = {}) {
 	psl::array<std::pair<pathstring, pathstring>> result;
 	psl::string append {};
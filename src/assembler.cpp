@@ -4,20 +4,28 @@
 #include "psl/string_utils.hpp"
 #include "psl/ustring.hpp"
 #include "stdafx.h"
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <fstream>
 #include <iostream>
 
 #ifdef WIN32
 	#include <fcntl.h>
 	#include <io.h>
 	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+	#include <unistd.h>
 #endif
 
+#include "batch.h"
 #include "cli/value.h"
-#include "generators/meta.h"
-#include "generators/models.h"
-#include "generators/shader.h"
+#include "server.h"
+#include "toolchain.h"
 
+#include "core/meta/shader.hpp"
 #include "core/resource/cache.hpp"
 
 #include "psl/collections/spmc.hpp"
@@ -92,6 +100,37 @@ psl::string_view get_input(int argc, char* argv[]) {
 #endif
 }
 
+struct memory_usage_t {
+	size_t current {0};
+	size_t peak {0};
+};
+
+memory_usage_t memory_usage() {
+	memory_usage_t result {};
+#ifdef WIN32
+	PROCESS_MEMORY_COUNTERS counters {};
+	if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		result.current = counters.WorkingSetSize;
+		result.peak	   = counters.PeakWorkingSetSize;
+	}
+#else
+	if(rusage usage {}; getrusage(RUSAGE_SELF, &usage) == 0) {
+	#if defined(__APPLE__)
+		result.peak = usage.ru_maxrss;
+	#else
+		result.peak = usage.ru_maxrss * 1024;
+	#endif
+	}
+	// only available on linux, elsewhere the current usage is left at 0
+	if(std::ifstream statm {"/proc/self/statm"}; statm) {
+		size_t pages {0}, resident {0};
+		if(statm >> pages >> resident)
+			result.current = resident * sysconf(_SC_PAGESIZE);
+	}
+#endif
+	return result;
+}
+
 #include "core/paradigm.hpp"
 #include "psl/application_utils.hpp"
 #include "psl/literals.hpp"
@@ -343,6 +382,7 @@ core::gfx::graphics_backend parse(std::string const& value) {
 }
 
 int main(int argc, char* argv[]) {
+	auto const start = std::chrono::steady_clock::now();
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 	_CrtSetReportMode(_CRT_ERROR, _CRTDBG_MODE_DEBUG);
 
@@ -373,34 +413,38 @@ int main(int argc, char* argv[]) {
 	//_setmode(_fileno(stdout), _O_U8TEXT);
 #endif
 
-	assembler::log->info(
-	  "welcome to assembler, use -h or --help to get information on the commands.\nyou can also pass "
-	  "the specific command (or its chain) after --help to get more information of that specific "
-	  "command, such as '--help generate shader'.\n");
-
-	assembler::generators::shader shader_gen {};
-	assembler::generators::models model_gen {};
-	assembler::generators::meta meta_gen {};
+	// in server mode stdout is reserved for the responses
+	auto const server_mode = std::any_of(
+	  argv + 1, argv + argc, [](char const* arg) { return psl::string8::view(arg) == "--server"; });
+	if(!server_mode)
+		assembler::log->info(
+		  "welcome to assembler, use -h or --help to get information on the commands.\nyou can also pass "
+		  "the specific command (or its chain) after --help to get more information of that specific "
+		  "command, such as '--help generate shader'.\n");
 
-	psl::cli::pack generator_pack {
-	  value<pack> {"shader", "glsl to spir-v compiler", {"shader", "s"}, std::move(shader_gen.pack())},
-	  value<pack> {"model", "model importer", {"models", "g"}, std::move(model_gen.pack())},
-	  value<pack> {"library", "meta library generator", {"library", "l"}, meta_gen.library_pack()},
-	  value<pack> {"meta", "meta file generator", {"meta", "m"}, meta_gen.meta_pack()}};
+	assembler::toolchain tools {};
+	assembler::batch batch {};
 
 	psl::cli::pack root {
 	  value<bool> {"exit", "quits the application", {"exit", "quit", "q"}, false},
+	  value<bool> {"stats", "report the startup time, command duration and memory usage", {"stats"}, false, true},
+	  value<bool> {"server",
+				   "keeps running and reads length prefixed requests from stdin, answering each on stdout",
+				   {"server"},
+				   false},
 	  value<std::string> {"graphical assembler",
 						  "launches the graphical editor (only one can be created)",
 						  {"geditor", "gassembler"},
 						  "",
 						  true,
 						  {{"vulkan", "gles"}}},
-	  value<pack> {"generator", "generator for various data files", {"generate", "g"}, generator_pack}
+	  value<pack> {"generator", "generator for various data files", {"generate", "g"}, tools.generators()},
+	  value<pack> {"batch", "runs the jobs of a manifest, concurrently where possible", {"batch"}, batch.pack()}
 
 	};
 
 	std::thread geditor_thread;
+	auto const startup = std::chrono::steady_clock::now() - start;
 
 
 	while(!root["exit"]->as<bool>().get()) {
@@ -416,7 +460,18 @@ int main(int argc, char* argv[]) {
 		}
 		psl::array<psl::string_view> commands = psl::utility::string::split(get_input(argc, argv), ("|"));
 		try {
+			auto const command_start = std::chrono::steady_clock::now();
 			root.parse(commands);
+			if(root["stats"]->as<bool>().get()) {
+				using milliseconds = std::chrono::duration<double, std::milli>;
+				auto const memory  = memory_usage();
+				assembler::log->info(
+				  "startup took {0:.2f}ms, the command took {1:.2f}ms, memory usage is {2:.2f}MiB (peak {3:.2f}MiB)",
+				  milliseconds(startup).count(),
+				  milliseconds(std::chrono::steady_clock::now() - command_start).count(),
+				  memory.current / (1024.0 * 1024.0),
+				  memory.peak / (1024.0 * 1024.0));
+			}
 		} catch(std::runtime_error const& re) {
 			std::cerr << "Runtime error: " << re.what() << std::endl;
 		} catch(std::exception const& ex) {
@@ -425,6 +480,10 @@ int main(int argc, char* argv[]) {
 			std::cerr << "Unknown failure occurred. Exiting the app" << std::endl;
 			break;
 		}
+		if(root["server"]->as<bool>().get()) {
+			assembler::server {root}.run();
+			break;
+		}
 	}
 	should_exit = true;
 	if(geditor_thread.joinable())
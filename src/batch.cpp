@@ -0,0 +1,249 @@
+#include "batch.h"
+#include "details/parallel.hpp"
+#include "psl/platform_utils.hpp"
+#include "psl/string_utils.hpp"
+#include "stdafx.h"
+#include "toolchain.h"
+#include "utils.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace psl;
+
+namespace assembler {
+psl::cli::pack batch::pack() {
+	return psl::cli::pack {
+	  std::bind(&assembler::batch::on_run, this, std::placeholders::_1),
+	  cli_value<psl::string> {"manifest", "location of the manifest that lists the jobs", {"manifest", "m"}, "", false},
+	  cli_value<size_t> {"jobs",
+						 "amount of jobs that are ran concurrently, 0 uses all available cores",
+						 {"jobs", "j"},
+						 0,
+						 true}};
+}
+
+bool batch::load(psl::string const& manifest) {
+	m_Jobs.clear();
+	auto content = utility::platform::file::read(manifest);
+	if(!content) {
+		utility::terminal::set_color(utility::terminal::color::RED);
+		assembler::log->error("ERROR: could not read the manifest '{}'", manifest);
+		utility::terminal::set_color(utility::terminal::color::WHITE);
+		return false;
+	}
+
+	size_t line_number = 0;
+	for(auto line : utility::string::split(content.value(), "\n")) {
+		++line_number;
+		line = trim(line);
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		job_t job {};
+		for(size_t open = line.find('['); open != psl::string_view::npos; open = line.find('[', open + 1)) {
+			auto const separator = line.find('=', open);
+			auto const close	 = line.find(']', open);
+			if(separator == psl::string_view::npos || close == psl::string_view::npos || separator > close) {
+				assembler::log->error("ERROR: malformed entry at line {0} of '{1}'", line_number, manifest);
+				return false;
+			}
+			auto const key	 = trim(line.substr(open + 1, separator - open - 1));
+			auto const value = trim(line.substr(separator + 1, close - separator - 1));
+			if(key == "NAME") {
+				job.name = value;
+			} else if(key == "COMMAND") {
+				job.command = value;
+			} else if(key == "DEPENDS") {
+				for(auto dependency : utility::string::split(value, ",")) {
+					if(dependency = trim(dependency); !dependency.empty())
+						job.depends.emplace_back(dependency);
+				}
+			} else {
+				assembler::log->error("ERROR: unknown key '{0}' at line {1} of '{2}'", key, line_number, manifest);
+				return false;
+			}
+			open = close;
+		}
+
+		if(job.name.empty() || job.command.empty()) {
+			assembler::log->error(
+			  "ERROR: the job at line {0} of '{1}' needs both a NAME and a COMMAND", line_number, manifest);
+			return false;
+		}
+		if(std::any_of(std::begin(m_Jobs), std::end(m_Jobs), [&job](auto const& other) {
+			   return other.name == job.name;
+		   })) {
+			assembler::log->error("ERROR: the job name '{0}' is used more than once in '{1}'", job.name, manifest);
+			return false;
+		}
+		m_Jobs.emplace_back(std::move(job));
+	}
+	return true;
+}
+
+bool batch::resolve(psl::array<psl::array<size_t>>& dependents, psl::array<size_t>& pending) const {
+	dependents = psl::array<psl::array<size_t>>(m_Jobs.size());
+	pending	   = psl::array<size_t>(m_Jobs.size(), 0);
+	for(size_t i = 0; i < m_Jobs.size(); ++i) {
+		std::set<size_t> dependencies {};
+		for(auto const& dependency : m_Jobs[i].depends) {
+			auto const prefix = !dependency.empty() && dependency.back() == '*';
+			auto const name	  = prefix ? psl::string_view(dependency).substr(0, dependency.size() - 1)
+									   : psl::string_view(dependency);
+			bool found		  = false;
+			for(size_t j = 0; j < m_Jobs.size(); ++j) {
+				if(j == i || (prefix ? !m_Jobs[j].name.starts_with(name) : m_Jobs[j].name != name))
+					continue;
+				found = true;
+				dependencies.insert(j);
+			}
+			if(!found) {
+				assembler::log->error("ERROR: the job '{0}' depends on '{1}', which matches no job",
+									  m_Jobs[i].name,
+									  dependency);
+				return false;
+			}
+		}
+		for(auto dependency : dependencies) dependents[dependency].emplace_back(i);
+		pending[i] = dependencies.size();
+	}
+
+	// a job that never becomes ready is part of (or depends on) a cycle
+	auto remaining = pending;
+	psl::array<size_t> ready {};
+	for(size_t i = 0; i < remaining.size(); ++i) {
+		if(remaining[i] == 0)
+			ready.emplace_back(i);
+	}
+	for(size_t i = 0; i < ready.size(); ++i) {
+		for(auto dependent : dependents[ready[i]]) {
+			if(--remaining[dependent] == 0)
+				ready.emplace_back(dependent);
+		}
+	}
+	if(ready.size() != m_Jobs.size()) {
+		for(size_t i = 0; i < remaining.size(); ++i) {
+			if(remaining[i] > 0)
+				assembler::log->error("ERROR: the job '{0}' is part of a dependency cycle", m_Jobs[i].name);
+		}
+		return false;
+	}
+	return true;
+}
+
+void batch::on_run(psl::cli::pack& pack) {
+	auto manifest = pack["manifest"]->as<psl::string>().get();
+	auto jobs	  = pack["jobs"]->as<size_t>().get();
+
+	psl::array<psl::array<size_t>> dependents {};
+	psl::array<size_t> pending {};
+	if(!load(manifest) || !resolve(dependents, pending))
+		return;
+	if(m_Jobs.empty()) {
+		assembler::log->warn("the manifest '{}' contains no jobs", manifest);
+		return;
+	}
+
+	enum class state_t : uint8_t { waiting, succeeded, failed, skipped };
+	psl::array<state_t> states(m_Jobs.size(), state_t::waiting);
+	psl::array<size_t> ready {};
+	for(size_t i = 0; i < m_Jobs.size(); ++i) {
+		if(pending[i] == 0)
+			ready.emplace_back(i);
+	}
+
+	auto parent = assembler::log;
+	std::mutex mutex;
+	std::condition_variable condition;
+	size_t finished = 0;
+
+	// skipping a job also skips everything that (transitively) depends on it, expects the mutex to be locked
+	std::function<void(size_t, size_t)> skip = [&](size_t index, size_t cause) {
+		if(states[index] != state_t::waiting)
+			return;
+		states[index] = state_t::skipped;
+		++finished;
+		parent->warn(
+		  "skipping '{0}', as its dependency '{1}' did not succeed", m_Jobs[index].name, m_Jobs[cause].name);
+		for(auto dependent : dependents[index]) skip(dependent, index);
+	};
+
+	// every worker gets its own set of generators, so they never share state
+	auto const workers = std::min(resolve_jobs(jobs), m_Jobs.size());
+	psl::array<std::unique_ptr<toolchain>> toolchains {};
+	for(size_t i = 0; i < workers; ++i) toolchains.emplace_back(std::make_unique<toolchain>());
+
+	auto worker = [&](toolchain& tools) {
+		psl::cli::pack root {cli_value<psl::cli::pack> {
+		  "generator", "generator for various data files", {"generate", "g"}, tools.generators()}};
+		while(true) {
+			size_t index {0};
+			{
+				std::unique_lock lock {mutex};
+				condition.wait(lock, [&]() { return !ready.empty() || finished == m_Jobs.size(); });
+				if(ready.empty())
+					return;
+				index = ready.back();
+				ready.pop_back();
+			}
+
+			auto const& job = m_Jobs[index];
+			auto sink		= std::make_shared<buffered_sink>();
+			assembler::log	= std::make_shared<spdlog::logger>("", sink);
+			assembler::log->set_level(parent->level());
+
+			bool success	 = false;
+			auto const start = std::chrono::high_resolution_clock::now();
+			try {
+				psl::array<psl::string_view> commands = psl::utility::string::split(job.command, ("|"));
+				success								  = root.parse(commands);
+			} catch(std::exception const& e) {
+				assembler::log->error("exception happened while running the job: {}", e.what());
+			} catch(...) {
+				assembler::log->error("unknown exception happened while running the job");
+			}
+			auto const duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+									std::chrono::high_resolution_clock::now() - start)
+									.count();
+			assembler::log.reset();
+			for(auto const& [level, message] : sink->messages()) success &= level < spdlog::level::err;
+
+			{
+				std::lock_guard lock {mutex};
+				parent->info("[{0}] {1} in {2}ms", job.name, success ? "finished" : "failed", duration);
+				sink->replay(*parent);
+				states[index] = success ? state_t::succeeded : state_t::failed;
+				++finished;
+				for(auto dependent : dependents[index]) {
+					if(!success)
+						skip(dependent, index);
+					else if(--pending[dependent] == 0 && states[dependent] == state_t::waiting)
+						ready.emplace_back(dependent);
+				}
+			}
+			condition.notify_all();
+		}
+	};
+
+	auto const start = std::chrono::high_resolution_clock::now();
+	psl::array<std::thread> threads {};
+	for(auto& tools : toolchains) threads.emplace_back(worker, std::ref(*tools));
+	for(auto& thread : threads) thread.join();
+	auto const duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+							std::chrono::high_resolution_clock::now() - start)
+							.count();
+
+	auto const count = [&states](state_t state) { return std::count(std::begin(states), std::end(states), state); };
+	assembler::log->info("ran {0} jobs using {1} workers in {2}ms, {3} succeeded, {4} failed, {5} were skipped\n",
+						 m_Jobs.size(),
+						 workers,
+						 duration,
+						 count(state_t::succeeded),
+						 count(state_t::failed),
+						 count(state_t::skipped));
+}
+}	 // namespace assembler
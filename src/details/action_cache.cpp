@@ -0,0 +1,153 @@
+#include "details/action_cache.hpp"
+#include "details/hash.hpp"
+#include "details/output.hpp"
+#include "psl/meta.hpp"
+#include "psl/platform_utils.hpp"
+#include "psl/serialization/serializer.hpp"
+#include "stdafx.h"
+
+#include <filesystem>
+
+using namespace psl;
+
+namespace details {
+struct cache_entry_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << version << outputs;
+	}
+
+	static constexpr char const serialization_name[6] {"CACHE"};
+	psl::serialization::property<"VERSION", uint64_t> version;
+	psl::serialization::property<"OUTPUTS", psl::array<psl::string>> outputs;	 // suffixes, stored by index
+};
+}	 // namespace details
+
+namespace assembler {
+action_cache::action_cache(psl::string directory) {
+	this->directory(std::move(directory));
+}
+
+void action_cache::directory(psl::string directory) {
+	m_Directory = utility::platform::directory::to_unix(directory);
+	if(!m_Directory.empty() && m_Directory.back() != '/')
+		m_Directory += '/';
+	if(!m_Directory.empty() && !utility::platform::directory::exists(m_Directory))
+		utility::platform::directory::create(m_Directory, true);
+}
+
+uint64_t action_cache::key(psl::string8::view generator,
+						   psl::string8::view input,
+						   psl::string8::view options) noexcept {
+	auto result = hash64(generator.data(), generator.size(), version);
+	result		= hash64(input.data(), input.size(), result);
+	return hash64(options.data(), options.size(), result);
+}
+
+psl::string action_cache::entry(uint64_t key) const {
+	return m_Directory + fmt::format("{:016x}", key);
+}
+
+bool action_cache::restore(uint64_t key, psl::string const& output) const {
+	if(!enabled())
+		return false;
+	auto const directory = entry(key);
+	if(!utility::platform::file::exists(directory + "/entry"))
+		return false;
+
+	details::cache_entry_t manifest {};
+	serialization::serializer s;
+	if(!s.deserialize<serialization::decode_from_format>(manifest, directory + "/entry") ||
+	   manifest.version.value != version)
+		return false;
+
+	auto const meta_extension = "." + psl::meta::META_EXTENSION;
+	for(size_t i = 0; i < manifest.outputs.value.size(); ++i) {
+		auto const& suffix		= manifest.outputs.value[i];
+		auto const source		= directory + "/" + utility::to_string(i);
+		auto const destination	= output + suffix;
+		auto const is_meta		= destination.size() >= meta_extension.size() &&
+							 destination.substr(destination.size() - meta_extension.size()) == meta_extension;
+
+		auto content = utility::platform::file::read(source);
+		if(!content) {
+			assembler::log->error("failed to read the cached file for {0}", destination);
+			return false;
+		}
+
+		if(!is_meta) {
+			if(!assembler::write_if_changed(destination, psl::to_string8_t(content.value()))) {
+				assembler::log->error("failed to restore {0} from the cache", destination);
+				return false;
+			}
+			continue;
+		}
+
+		psl::UID uid = psl::UID::generate();
+		if(utility::platform::file::exists(destination)) {
+			psl::meta::file* original = nullptr;
+			if(s.deserialize<serialization::decode_from_format>(original, destination) && original)
+				uid = original->ID();
+			delete(original);
+		}
+
+		format::container cont {psl::to_string8_t(content.value())};
+		auto metaNode = cont.find("META");
+		auto node	  = cont.find(metaNode.get(), "UID");
+		cont.remove(node.get());
+		cont.add_value(metaNode.get(), "UID", utility::to_string(uid));
+		if(!assembler::write_if_changed(destination, cont.to_string())) {
+			assembler::log->error("failed to restore {0} from the cache", destination);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool action_cache::store(uint64_t key, psl::string const& output, psl::array<psl::string> const& suffixes) const {
+	if(!enabled())
+		return false;
+	auto const directory = entry(key);
+	if(utility::platform::file::exists(directory + "/entry"))
+		return true;
+
+	// populate a uniquely named directory first, and move it into place when complete.
+	auto const staging = directory + "." + utility::to_string(psl::UID::generate());
+	utility::platform::directory::create(staging, true);
+
+	details::cache_entry_t manifest {};
+	manifest.version.value = version;
+	for(auto const& suffix : suffixes) {
+		auto const source = output + suffix;
+		if(!utility::platform::file::exists(source))
+			continue;
+		std::error_code error {};
+		std::filesystem::copy_file(utility::platform::file::to_platform(source),
+								   utility::platform::file::to_platform(
+									 staging + "/" + utility::to_string(manifest.outputs.value.size())),
+								   std::filesystem::copy_options::overwrite_existing,
+								   error);
+		if(error) {
+			assembler::log->error("failed to store {0} in the cache: {1}", source, error.message());
+			std::filesystem::remove_all(utility::platform::file::to_platform(staging), error);
+			return false;
+		}
+		manifest.outputs.value.emplace_back(suffix);
+	}
+
+	serialization::serializer s;
+	format::container cont;
+	s.serialize<serialization::encode_to_format>(manifest, cont);
+	utility::platform::file::write(staging + "/entry", psl::from_string8_t(cont.to_string()));
+
+	// another process might have stored the same entry in the meantime, in which case ours is discarded
+	std::error_code error {};
+	std::filesystem::rename(utility::platform::file::to_platform(staging),
+							utility::platform::file::to_platform(directory),
+							error);
+	if(error)
+		std::filesystem::remove_all(utility::platform::file::to_platform(staging), error);
+	return true;
+}
+}	 // namespace assembler
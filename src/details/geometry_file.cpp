@@ -0,0 +1,274 @@
+#include "details/geometry_file.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace tools {
+namespace {
+	template <typename T>
+	void append(psl::string8_t& output, T value) {
+		if constexpr(std::is_floating_point_v<T>) {
+			append(output, std::bit_cast<uint32_t>(static_cast<float>(value)));
+		} else {
+			for(size_t i = 0; i < sizeof(T); ++i) output.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+		}
+	}
+
+	template <typename T>
+	void store(psl::array<uint8_t>& data, T value) {
+		for(size_t i = 0; i < sizeof(T); ++i) data.emplace_back(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+	}
+
+	uint16_t to_unorm16(float value) noexcept {
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t to_snorm16(float value) noexcept {
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	uint8_t to_unorm8(float value) noexcept {
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+	}
+
+	geometry_stream_t make_stream(psl::string_view name, vertex_format_t format, uint8_t components, size_t vertices) {
+		geometry_stream_t result {};
+		result.name		  = psl::string {name};
+		result.format	  = format;
+		result.components = components;
+		result.data.reserve(vertices * result.stride());
+		return result;
+	}
+}	 // namespace
+
+uint16_t to_half(float value) noexcept {
+	auto const bits		= std::bit_cast<uint32_t>(value);
+	auto const sign		= static_cast<uint16_t>((bits >> 16) & 0x8000u);
+	auto const absolute = bits & 0x7FFFFFFFu;
+
+	if(absolute > 0x7F800000u)	  // NaN
+		return sign | 0x7E00u;
+	if(absolute >= 0x477FF000u)	   // rounds to a value larger than the largest half, or infinity
+		return sign | 0x7C00u;
+	if(absolute < 0x38800000u) {
+		// denormal half, shift the mantissa (with its implicit bit) into place and round to nearest even
+		if(absolute < 0x33000000u)
+			return sign;
+		auto const exponent = absolute >> 23;
+		auto const mantissa = (absolute & 0x7FFFFFu) | 0x800000u;
+		auto const shift	= 126u - exponent;
+		auto half			= mantissa >> shift;
+		auto const rest		= mantissa & ((1u << shift) - 1u);
+		auto const halfway	= 1u << (shift - 1u);
+		if(rest > halfway || (rest == halfway && (half & 1u)))
+			++half;
+		return sign | static_cast<uint16_t>(half);
+	}
+
+	// rebias the exponent, and round the mantissa to nearest even, a carry correctly bumps the exponent
+	auto half = absolute - 0x38000000u;
+	half += 0x0FFFu + ((half >> 13) & 1u);
+	return sign | static_cast<uint16_t>(half >> 13);
+}
+
+geometry_stream_t encode_float(psl::string_view name, std::span<float const> values, uint8_t components) {
+	auto result = make_stream(name, vertex_format_t::float32, components, values.size() / components);
+	for(auto value : values) store(result.data, std::bit_cast<uint32_t>(value));
+	return result;
+}
+
+geometry_stream_t quantize_position(psl::string_view name, std::span<float const> values) {
+	auto const vertices = values.size() / 3;
+	auto result			= make_stream(name, vertex_format_t::unorm16, 4, vertices);
+	if(vertices == 0)
+		return result;
+
+	for(size_t axis = 0; axis < 3; ++axis) {
+		auto lowest	 = values[axis];
+		auto highest = values[axis];
+		for(size_t v = 1; v < vertices; ++v) {
+			lowest	= std::min(lowest, values[v * 3 + axis]);
+			highest = std::max(highest, values[v * 3 + axis]);
+		}
+		result.offset[axis] = lowest;
+		result.scale[axis]	= highest - lowest;
+	}
+	result.scale[3] = 0.0f;
+
+	for(size_t v = 0; v < vertices; ++v) {
+		for(size_t axis = 0; axis < 3; ++axis) {
+			auto const extent = result.scale[axis];
+			store(result.data,
+				  to_unorm16((extent > 0.0f) ? (values[v * 3 + axis] - result.offset[axis]) / extent : 0.0f));
+		}
+		store(result.data, uint16_t {0});
+	}
+	return result;
+}
+
+geometry_stream_t quantize_direction(psl::string_view name, std::span<float const> values) {
+	auto const vertices = values.size() / 3;
+	auto result			= make_stream(name, vertex_format_t::snorm16_octahedral, 2, vertices);
+	for(size_t v = 0; v < vertices; ++v) {
+		auto x			  = values[v * 3];
+		auto y			  = values[v * 3 + 1];
+		auto const z	  = values[v * 3 + 2];
+		auto const length = std::abs(x) + std::abs(y) + std::abs(z);
+		if(length > 0.0f) {
+			x /= length;
+			y /= length;
+		}
+		// the lower hemisphere gets folded over the diagonals
+		if(z < 0.0f) {
+			auto const folded_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			auto const folded_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x					= folded_x;
+			y					= folded_y;
+		}
+		store(result.data, static_cast<uint16_t>(to_snorm16(x)));
+		store(result.data, static_cast<uint16_t>(to_snorm16(y)));
+	}
+	return result;
+}
+
+geometry_stream_t quantize_uv(psl::string_view name, std::span<float const> values) {
+	auto result = make_stream(name, vertex_format_t::float16, 2, values.size() / 2);
+	for(auto value : values) store(result.data, to_half(value));
+	return result;
+}
+
+geometry_stream_t quantize_color(psl::string_view name, std::span<float const> values) {
+	auto result = make_stream(name, vertex_format_t::unorm8, 4, values.size() / 4);
+	for(auto value : values) store(result.data, to_unorm8(value));
+	return result;
+}
+
+buffer_layout_t layout_streams(std::span<size_t const> strides, vertex_layout_t layout, size_t alignment) {
+	alignment = std::max<size_t>(alignment, 1u);
+	auto const align = [alignment](size_t value) { return (value + alignment - 1) / alignment * alignment; };
+
+	buffer_layout_t result {};
+	for(size_t i = 0; i < strides.size(); ++i) {
+		uint32_t buffer {0};
+		switch(layout) {
+		case vertex_layout_t::separate:
+			buffer = static_cast<uint32_t>(i);
+			break;
+		case vertex_layout_t::interleaved:
+			buffer = 0;
+			break;
+		case vertex_layout_t::hybrid:
+			buffer = (i == 0) ? 0 : 1;
+			break;
+		}
+		if(buffer == result.strides.size())
+			result.strides.emplace_back(0);
+		result.bindings.emplace_back(stream_binding_t {buffer, result.strides[buffer]});
+		result.strides[buffer] = static_cast<uint32_t>(align(result.strides[buffer] + strides[i]));
+	}
+	return result;
+}
+
+uint32_t geometry_file_t::index_size() const noexcept {
+	auto const fits = std::all_of(std::begin(indices), std::end(indices), [](uint32_t index) {
+		return index < std::numeric_limits<uint16_t>::max();
+	});
+	return fits ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+psl::string8_t geometry_file_t::encode() const {
+	constexpr size_t header_size {12 * sizeof(uint32_t)};
+	constexpr size_t stream_entry_size {5 * sizeof(uint32_t) + 8 * sizeof(float)};
+	constexpr size_t buffer_entry_size {4 * sizeof(uint32_t)};
+	auto const align = [](size_t value) { return (value + blob_alignment - 1) / blob_alignment * blob_alignment; };
+
+	auto const index_bytes	= index_size();
+	auto const vertex_count = streams.empty() ? size_t {0} : streams[0].vertex_count();
+
+	psl::array<size_t> strides {};
+	for(auto const& stream : streams) strides.emplace_back(stream.stride());
+	auto const buffers = layout_streams(strides, layout, alignment);
+
+	// the tables are followed by the string table, and then by the blobs at their aligned offsets
+	auto const strings_offset =
+	  header_size + streams.size() * stream_entry_size + buffers.strides.size() * buffer_entry_size;
+	size_t strings_size {0};
+	for(auto const& stream : streams) strings_size += stream.name.size();
+
+	psl::array<size_t> buffer_offsets {};
+	auto end = strings_offset + strings_size;
+	for(auto stride : buffers.strides) {
+		buffer_offsets.emplace_back(align(end));
+		end = buffer_offsets.back() + vertex_count * stride;
+	}
+	auto const index_offset = align(end);
+	auto const file_size	= index_offset + indices.size() * index_bytes;
+
+	psl::string8_t output {};
+	output.reserve(file_size);
+	output.append("PGB", 4);
+	append(output, version);
+	append(output, static_cast<uint32_t>(streams.size()));
+	append(output, static_cast<uint32_t>(buffers.strides.size()));
+	append(output, static_cast<uint32_t>(vertex_count));
+	append(output, static_cast<uint32_t>(indices.size()));
+	append(output, index_bytes);
+	append(output, static_cast<uint32_t>(index_offset));
+	append(output, static_cast<uint32_t>(indices.size() * index_bytes));
+	append(output, static_cast<uint32_t>(strings_offset));
+	append(output, static_cast<uint32_t>(strings_size));
+	append(output, static_cast<uint32_t>(file_size));
+
+	size_t name_offset {strings_offset};
+	for(size_t i = 0; i < streams.size(); ++i) {
+		auto const& stream = streams[i];
+		append(output, static_cast<uint32_t>(name_offset));
+		append(output, static_cast<uint32_t>(stream.name.size()));
+		append(output, buffers.bindings[i].offset);
+		append(output, buffers.bindings[i].buffer);
+		append(output, static_cast<uint8_t>(stream.format));
+		append(output, stream.components);
+		append(output, uint16_t {0});
+		for(auto value : stream.scale) append(output, value);
+		for(auto value : stream.offset) append(output, value);
+		name_offset += stream.name.size();
+	}
+
+	for(size_t buffer = 0; buffer < buffers.strides.size(); ++buffer) {
+		append(output, static_cast<uint32_t>(buffer_offsets[buffer]));
+		append(output, static_cast<uint32_t>(vertex_count * buffers.strides[buffer]));
+		append(output, buffers.strides[buffer]);
+		append(output, uint32_t {0});
+	}
+
+	for(auto const& stream : streams) output.append(stream.name.data(), stream.name.size());
+
+	for(uint32_t buffer = 0; buffer < buffers.strides.size(); ++buffer) {
+		auto const stride = buffers.strides[buffer];
+		output.resize(buffer_offsets[buffer], '\0');
+		psl::array<uint8_t> data(vertex_count * stride, 0);
+		for(size_t i = 0; i < streams.size(); ++i) {
+			if(buffers.bindings[i].buffer != buffer)
+				continue;
+			auto const size = streams[i].stride();
+			for(size_t v = 0; v < vertex_count; ++v) {
+				std::copy_n(std::next(std::begin(streams[i].data), v * size),
+							size,
+							std::next(std::begin(data), v * stride + buffers.bindings[i].offset));
+			}
+		}
+		output.append(reinterpret_cast<char const*>(data.data()), data.size());
+	}
+
+	output.resize(index_offset, '\0');
+	for(auto index : indices) {
+		if(index_bytes == sizeof(uint16_t))
+			append(output, static_cast<uint16_t>(index));
+		else
+			append(output, index);
+	}
+	return output;
+}
+}	 // namespace tools
@@ -0,0 +1,828 @@
+#include "details/mesh_optimizer.hpp"
+#include "psl/array.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace tools {
+namespace {
+	// tuning values from Tom Forsyth's article
+	constexpr size_t forsyth_cache_size {32};
+	constexpr float cache_decay_power {1.5f};
+	constexpr float last_triangle_score {0.75f};
+	constexpr float valence_boost_scale {2.0f};
+	constexpr float valence_boost_power {0.5f};
+
+	float vertex_score(int32_t cache_position, uint32_t remaining) noexcept {
+		if(remaining == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if(cache_position >= 0) {
+			// the vertices of the last triangle get a fixed score, so the next triangle doesn't prefer any of its edges
+			score = (cache_position < 3)
+					  ? last_triangle_score
+					  : std::pow(1.0f - static_cast<float>(cache_position - 3) / (forsyth_cache_size - 3),
+								 cache_decay_power);
+		}
+		// vertices with few remaining triangles get boosted, so they get finished off instead of left behind
+		return score + valence_boost_scale * std::pow(static_cast<float>(remaining), -valence_boost_power);
+	}
+
+	// all triangles that use a vertex, the triangles of vertex `v` are in [offsets[v], offsets[v] + counts[v])
+	struct adjacency_t {
+		psl::array<uint32_t> offsets {};
+		psl::array<uint32_t> counts {};
+		psl::array<uint32_t> triangles {};
+	};
+
+	adjacency_t build_adjacency(std::span<uint32_t const> indices, size_t vertex_count) {
+		adjacency_t result {};
+		result.counts.resize(vertex_count, 0);
+		for(auto index : indices) ++result.counts[index];
+
+		result.offsets.resize(vertex_count, 0);
+		std::exclusive_scan(std::begin(result.counts), std::end(result.counts), std::begin(result.offsets), 0u);
+
+		auto cursor = result.offsets;
+		result.triangles.resize(indices.size());
+		for(size_t i = 0; i < indices.size(); ++i) result.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		return result;
+	}
+
+	// FIFO cache, a vertex is still cached when it was inserted less than `cache_size` insertions ago
+	struct fifo_cache_t {
+		fifo_cache_t(size_t vertex_count, size_t cache_size) :
+			timestamps(vertex_count, 0), cache_size(static_cast<uint32_t>(cache_size)),
+			timestamp(static_cast<uint32_t>(cache_size) + 1) {}
+
+		// returns true on a cache miss
+		bool access(uint32_t vertex) noexcept {
+			if(timestamp - timestamps[vertex] <= cache_size)
+				return false;
+			timestamps[vertex] = timestamp++;
+			return true;
+		}
+
+		size_t access(std::span<uint32_t const> triangle) noexcept {
+			return access(triangle[0]) + access(triangle[1]) + access(triangle[2]);
+		}
+
+		void flush() noexcept { timestamp += cache_size + 1; }
+
+		psl::array<uint32_t> timestamps;
+		uint32_t cache_size;
+		uint32_t timestamp;
+	};
+
+	// symmetric 4x4 matrix of the summed squared distances to a set of planes, divided by their total weight
+	struct quadric_t {
+		double a2 {0}, b2 {0}, c2 {0}, d2 {0}, ab {0}, ac {0}, ad {0}, bc {0}, bd {0}, cd {0};
+		double weight {0};
+
+		static quadric_t plane(double a, double b, double c, double d, double weight) noexcept {
+			return quadric_t {a * a * weight,
+							  b * b * weight,
+							  c * c * weight,
+							  d * d * weight,
+							  a * b * weight,
+							  a * c * weight,
+							  a * d * weight,
+							  b * c * weight,
+							  b * d * weight,
+							  c * d * weight,
+							  weight};
+		}
+
+		quadric_t& operator+=(quadric_t const& other) noexcept {
+			a2 += other.a2;
+			b2 += other.b2;
+			c2 += other.c2;
+			d2 += other.d2;
+			ab += other.ab;
+			ac += other.ac;
+			ad += other.ad;
+			bc += other.bc;
+			bd += other.bd;
+			cd += other.cd;
+			weight += other.weight;
+			return *this;
+		}
+
+		friend quadric_t operator+(quadric_t lhs, quadric_t const& rhs) noexcept { return lhs += rhs; }
+
+		// mean squared distance of the point to the planes
+		double error(std::array<double, 3> const& p) const noexcept {
+			auto const rx = a2 * p[0] + ab * p[1] + ac * p[2] + ad;
+			auto const ry = ab * p[0] + b2 * p[1] + bc * p[2] + bd;
+			auto const rz = ac * p[0] + bc * p[1] + c2 * p[2] + cd;
+			auto const r  = rx * p[0] + ry * p[1] + rz * p[2] + ad * p[0] + bd * p[1] + cd * p[2] + d2;
+			return (weight > 0.0) ? std::abs(r) / weight : 0.0;
+		}
+	};
+
+	std::array<double, 3> subtract(std::array<double, 3> const& lhs, std::array<double, 3> const& rhs) noexcept {
+		return {lhs[0] - rhs[0], lhs[1] - rhs[1], lhs[2] - rhs[2]};
+	}
+
+	std::array<double, 3> cross(std::array<double, 3> const& lhs, std::array<double, 3> const& rhs) noexcept {
+		return {lhs[1] * rhs[2] - lhs[2] * rhs[1], lhs[2] * rhs[0] - lhs[0] * rhs[2], lhs[0] * rhs[1] - lhs[1] * rhs[0]};
+	}
+
+	double dot(std::array<double, 3> const& lhs, std::array<double, 3> const& rhs) noexcept {
+		return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+	}
+}	 // namespace
+
+vertex_cache_statistics_t
+analyze_vertex_cache(std::span<uint32_t const> indices, size_t vertex_count, size_t cache_size) {
+	vertex_cache_statistics_t result {};
+	result.triangles = indices.size() / 3;
+
+	fifo_cache_t cache {vertex_count, cache_size};
+	psl::array<uint8_t> used(vertex_count, 0);
+	for(auto index : indices) {
+		result.misses += cache.access(index);
+		result.vertices += (used[index] == 0);
+		used[index] = 1;
+	}
+	return result;
+}
+
+vertex_fetch_statistics_t analyze_vertex_fetch(std::span<uint32_t const> indices,
+											   size_t vertex_count,
+											   std::span<size_t const> strides,
+											   size_t cache_line,
+											   size_t cache_lines) {
+	// direct mapped cache of the cache lines, which is close to how a set associative cache behaves on mesh data
+	vertex_fetch_statistics_t result {};
+	psl::array<size_t> cache(cache_lines, std::numeric_limits<size_t>::max());
+
+	for(auto index : indices) {
+		size_t base = 0;
+		for(auto stride : strides) {
+			auto const begin = base + index * stride;
+			for(auto line = begin / cache_line; line <= (begin + stride - 1) / cache_line; ++line) {
+				auto& entry = cache[line % cache_lines];
+				if(entry == line) {
+					++result.hits;
+				} else {
+					++result.misses;
+					entry = line;
+				}
+			}
+			// every stream starts on a new cache line
+			base += (vertex_count * stride + cache_line - 1) / cache_line * cache_line;
+		}
+	}
+	return result;
+}
+
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count) {
+	auto const triangle_count = indices.size() / 3;
+	if(triangle_count == 0 || vertex_count == 0)
+		return;
+
+	auto adjacency	= build_adjacency(indices, vertex_count);
+	auto& remaining = adjacency.counts;
+
+	psl::array<int32_t> cache_positions(vertex_count, -1);
+	psl::array<float> vertex_scores(vertex_count);
+	for(size_t v = 0; v < vertex_count; ++v) vertex_scores[v] = vertex_score(-1, remaining[v]);
+
+	psl::array<float> triangle_scores(triangle_count);
+	for(size_t t = 0; t < triangle_count; ++t)
+		triangle_scores[t] =
+		  vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+
+	psl::array<uint8_t> emitted(triangle_count, 0);
+	psl::array<uint32_t> result {};
+	result.reserve(indices.size());
+
+	// three extra slots for the vertices that get pushed out of the cache by the last triangle
+	std::array<uint32_t, forsyth_cache_size + 3> cache {};
+	std::array<uint32_t, forsyth_cache_size + 3> next {};
+	size_t cache_count = 0;
+
+	size_t cursor	= 0;
+	auto const max	= std::max_element(std::begin(triangle_scores), std::end(triangle_scores));
+	auto best		= static_cast<size_t>(std::distance(std::begin(triangle_scores), max));
+	while(best < triangle_count) {
+		emitted[best] = 1;
+		auto const triangle = indices.subspan(best * 3, 3);
+
+		size_t next_count = 0;
+		for(auto vertex : triangle) {
+			result.emplace_back(vertex);
+
+			auto begin = std::next(std::begin(adjacency.triangles), adjacency.offsets[vertex]);
+			auto end   = std::next(begin, remaining[vertex]);
+			std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best)), std::prev(end));
+			--remaining[vertex];
+
+			if(std::find(std::begin(next), std::next(std::begin(next), next_count), vertex) ==
+			   std::next(std::begin(next), next_count))
+				next[next_count++] = vertex;
+		}
+		for(size_t i = 0; i < cache_count; ++i) {
+			if(std::find(std::begin(triangle), std::end(triangle), cache[i]) == std::end(triangle))
+				next[next_count++] = cache[i];
+		}
+
+		for(size_t i = 0; i < next_count; ++i) {
+			auto const vertex		= next[i];
+			cache_positions[vertex] = (i < forsyth_cache_size) ? static_cast<int32_t>(i) : -1;
+			vertex_scores[vertex]	= vertex_score(cache_positions[vertex], remaining[vertex]);
+		}
+		cache_count = std::min(next_count, forsyth_cache_size);
+		std::copy_n(std::begin(next), cache_count, std::begin(cache));
+
+		// only the triangles that touch a vertex whose score changed need to be rescored
+		best			= triangle_count;
+		auto best_score = std::numeric_limits<float>::lowest();
+		for(size_t i = 0; i < next_count; ++i) {
+			auto const vertex = next[i];
+			for(uint32_t j = 0; j < remaining[vertex]; ++j) {
+				auto const t = adjacency.triangles[adjacency.offsets[vertex] + j];
+				triangle_scores[t] =
+				  vertex_scores[indices[t * 3]] + vertex_scores[indices[t * 3 + 1]] + vertex_scores[indices[t * 3 + 2]];
+				if(triangle_scores[t] > best_score) {
+					best_score = triangle_scores[t];
+					best	   = t;
+				}
+			}
+		}
+
+		// none of the cached vertices have triangles left, continue with the next triangle in the original order
+		if(best == triangle_count) {
+			while(cursor < triangle_count && emitted[cursor]) ++cursor;
+			best = cursor;
+		}
+	}
+
+	std::copy(std::begin(result), std::end(result), std::begin(indices));
+}
+
+void optimize_overdraw(std::span<uint32_t> indices, std::span<psl::vec3 const> positions, float threshold) {
+	constexpr size_t cache_size {16};
+	auto const triangle_count = indices.size() / 3;
+	if(triangle_count == 0 || positions.empty())
+		return;
+
+	// hard boundaries, the triangles that miss the cache on all of their vertices start a new cluster
+	psl::array<size_t> hard {};
+	{
+		fifo_cache_t cache {positions.size(), cache_size};
+		for(size_t t = 0; t < triangle_count; ++t) {
+			if(cache.access(indices.subspan(t * 3, 3)) == 3 || t == 0)
+				hard.emplace_back(t);
+		}
+	}
+	hard.emplace_back(triangle_count);
+
+	// soft boundaries, split the hard clusters wherever the running ACMR gets within the threshold of the cluster's
+	psl::array<size_t> clusters {};
+	fifo_cache_t cache {positions.size(), cache_size};
+	for(size_t c = 0; c + 1 < hard.size(); ++c) {
+		auto const begin = hard[c];
+		auto const end	 = hard[c + 1];
+
+		size_t misses = 0;
+		for(size_t t = begin; t < end; ++t) misses += cache.access(indices.subspan(t * 3, 3));
+		auto const target = threshold * static_cast<float>(misses) / static_cast<float>(end - begin);
+
+		clusters.emplace_back(begin);
+		cache.flush();
+		size_t running_misses	 = 0;
+		size_t running_triangles = 0;
+		for(size_t t = begin; t + 1 < end; ++t) {
+			running_misses += cache.access(indices.subspan(t * 3, 3));
+			++running_triangles;
+			if(static_cast<float>(running_misses) / static_cast<float>(running_triangles) <= target) {
+				clusters.emplace_back(t + 1);
+				cache.flush();
+				running_misses	  = 0;
+				running_triangles = 0;
+			}
+		}
+		cache.flush();
+	}
+	clusters.emplace_back(triangle_count);
+
+	auto position = [&positions](uint32_t index, size_t axis) { return positions[index][axis]; };
+
+	std::array<float, 3> mesh_centroid {};
+	for(size_t v = 0; v < positions.size(); ++v) {
+		for(size_t axis = 0; axis < 3; ++axis) mesh_centroid[axis] += position(static_cast<uint32_t>(v), axis);
+	}
+	for(auto& value : mesh_centroid) value /= static_cast<float>(positions.size());
+
+	// clusters that face away from the center of the mesh are likely to occlude the others, so they get drawn first
+	auto const cluster_count = clusters.size() - 1;
+	psl::array<float> sort_keys(cluster_count, 0.0f);
+	for(size_t c = 0; c < cluster_count; ++c) {
+		std::array<float, 3> centroid {};
+		std::array<float, 3> normal {};
+		float area = 0.0f;
+		for(size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+			auto const a = indices[t * 3];
+			auto const b = indices[t * 3 + 1];
+			auto const d = indices[t * 3 + 2];
+			std::array<float, 3> ab {}, ad {};
+			for(size_t axis = 0; axis < 3; ++axis) {
+				ab[axis] = position(b, axis) - position(a, axis);
+				ad[axis] = position(d, axis) - position(a, axis);
+			}
+			// the length of the cross product is twice the area, so the normals and centroids are area weighted
+			std::array<float, 3> const cross {
+			  ab[1] * ad[2] - ab[2] * ad[1], ab[2] * ad[0] - ab[0] * ad[2], ab[0] * ad[1] - ab[1] * ad[0]};
+			auto const weight = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+			for(size_t axis = 0; axis < 3; ++axis) {
+				normal[axis] += cross[axis];
+				centroid[axis] += weight * (position(a, axis) + position(b, axis) + position(d, axis)) / 3.0f;
+			}
+			area += weight;
+		}
+
+		auto const length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(area <= 0.0f || length <= 0.0f)
+			continue;
+		for(size_t axis = 0; axis < 3; ++axis)
+			sort_keys[c] += (centroid[axis] / area - mesh_centroid[axis]) * (normal[axis] / length);
+	}
+
+	psl::array<size_t> order(cluster_count);
+	std::iota(std::begin(order), std::end(order), size_t {0});
+	std::stable_sort(std::begin(order), std::end(order), [&sort_keys](size_t lhs, size_t rhs) {
+		return sort_keys[lhs] > sort_keys[rhs];
+	});
+
+	psl::array<uint32_t> result {};
+	result.reserve(indices.size());
+	for(auto c : order) {
+		result.insert(std::end(result),
+					  std::next(std::begin(indices), clusters[c] * 3),
+					  std::next(std::begin(indices), clusters[c + 1] * 3));
+	}
+	std::copy(std::begin(result), std::end(result), std::begin(indices));
+}
+
+psl::array<uint32_t> optimize_vertex_fetch(std::span<uint32_t> indices, size_t vertex_count) {
+	constexpr auto unused = std::numeric_limits<uint32_t>::max();
+	psl::array<uint32_t> remap(vertex_count, unused);
+	psl::array<uint32_t> order {};
+	order.reserve(vertex_count);
+
+	for(auto& index : indices) {
+		if(remap[index] == unused) {
+			remap[index] = static_cast<uint32_t>(order.size());
+			order.emplace_back(index);
+		}
+		index = remap[index];
+	}
+	return order;
+}
+
+psl::array<size_t> split_by_vertex_count(std::span<uint32_t const> indices, size_t vertex_count, size_t max_vertices) {
+	psl::array<size_t> result {0};
+	psl::array<size_t> used(vertex_count, 0);	 // run (plus one) that last used the vertex
+	size_t run_vertices = 0;
+	for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+		auto const run = result.size();
+		size_t added   = 0;
+		for(size_t k = 0; k < 3; ++k) {
+			auto const index = indices[i + k];
+			added += (used[index] != run) && std::find(&indices[i], &indices[i + k], index) == &indices[i + k];
+		}
+		if(run_vertices + added > max_vertices && i > result.back()) {
+			result.emplace_back(i);
+			run_vertices = 0;
+		}
+		for(size_t k = 0; k < 3; ++k) {
+			if(auto& last = used[indices[i + k]]; last != result.size()) {
+				last = result.size();
+				++run_vertices;
+			}
+		}
+	}
+	result.emplace_back(indices.size());
+	return result;
+}
+
+namespace {
+	void compute_bounds(meshlets_t& result, meshlet_t& meshlet, std::span<float const> positions) {
+		auto const vertices = std::span {result.vertices}.subspan(meshlet.vertex_offset, meshlet.vertex_count);
+		auto const position = [&positions](uint32_t vertex) {
+			return std::array<double, 3> {positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]};
+		};
+
+		// the sphere is centered on the bounds, which is within a few percent of the minimal sphere for meshlets
+		std::array<double, 3> min = position(vertices[0]), max = position(vertices[0]);
+		for(auto vertex : vertices) {
+			auto const p = position(vertex);
+			for(size_t axis = 0; axis < 3; ++axis) {
+				min[axis] = std::min(min[axis], p[axis]);
+				max[axis] = std::max(max[axis], p[axis]);
+			}
+		}
+		std::array<double, 3> center {(min[0] + max[0]) / 2.0, (min[1] + max[1]) / 2.0, (min[2] + max[2]) / 2.0};
+		double radius = 0.0;
+		for(auto vertex : vertices) {
+			auto const offset = subtract(position(vertex), center);
+			radius			  = std::max(radius, dot(offset, offset));
+		}
+
+		psl::array<std::array<double, 3>> normals {};
+		psl::array<std::array<double, 3>> corners {};
+		std::array<double, 3> axis {};
+		for(size_t t = 0; t < meshlet.triangle_count; ++t) {
+			auto const triangle = (meshlet.triangle_offset + t) * 3;
+			auto const p0		= position(vertices[result.triangles[triangle]]);
+			auto normal			= cross(subtract(position(vertices[result.triangles[triangle + 1]]), p0),
+								subtract(position(vertices[result.triangles[triangle + 2]]), p0));
+			auto const length	= std::sqrt(dot(normal, normal));
+			if(length <= 0.0)
+				continue;
+			for(size_t i = 0; i < 3; ++i) {
+				normal[i] /= length;
+				axis[i] += normal[i];
+			}
+			normals.emplace_back(normal);
+			corners.emplace_back(p0);
+		}
+
+		for(size_t i = 0; i < 3; ++i) meshlet.center[i] = static_cast<float>(center[i]);
+		meshlet.radius		= static_cast<float>(std::sqrt(radius));
+		meshlet.cone_apex	= meshlet.center;
+		meshlet.cone_cutoff = 1.0f;
+
+		auto const axis_length = std::sqrt(dot(axis, axis));
+		if(normals.empty() || axis_length <= 0.0)
+			return;
+		for(auto& value : axis) value /= axis_length;
+
+		// the cone has to contain all normals, it can't be culled when they span more than a hemisphere
+		auto min_dot = 1.0;
+		for(auto const& normal : normals) min_dot = std::min(min_dot, dot(normal, axis));
+		if(min_dot <= 0.0)
+			return;
+
+		// the apex is moved back along the axis until it is behind the planes of all triangles
+		double max_distance = 0.0;
+		for(size_t i = 0; i < normals.size(); ++i) {
+			auto const distance = dot(subtract(center, corners[i]), normals[i]) / dot(axis, normals[i]);
+			max_distance		= std::max(max_distance, distance);
+		}
+		for(size_t i = 0; i < 3; ++i) {
+			meshlet.cone_axis[i] = static_cast<float>(axis[i]);
+			meshlet.cone_apex[i] = static_cast<float>(center[i] - axis[i] * max_distance);
+		}
+		meshlet.cone_cutoff = static_cast<float>(std::sqrt(1.0 - min_dot * min_dot));
+	}
+}	 // namespace
+
+meshlets_t build_meshlets(std::span<uint32_t const> indices,
+						  std::span<float const> positions,
+						  size_t max_vertices,
+						  size_t max_triangles) {
+	constexpr auto unused = std::numeric_limits<uint32_t>::max();
+	max_vertices		  = std::clamp<size_t>(max_vertices, 3u, 256u);
+	max_triangles		  = std::max<size_t>(max_triangles, 1u);
+
+	meshlets_t result {};
+	psl::array<uint32_t> local(positions.size() / 3, unused);
+	meshlet_t current {};
+
+	auto finish = [&]() {
+		if(current.triangle_count == 0)
+			return;
+		for(uint32_t i = 0; i < current.vertex_count; ++i) local[result.vertices[current.vertex_offset + i]] = unused;
+		compute_bounds(result, current, positions);
+		result.meshlets.emplace_back(current);
+		current					= meshlet_t {};
+		current.vertex_offset	= static_cast<uint32_t>(result.vertices.size());
+		current.triangle_offset = static_cast<uint32_t>(result.triangles.size() / 3);
+	};
+
+	for(size_t i = 0; i + 2 < indices.size(); i += 3) {
+		size_t added = 0;
+		for(size_t k = 0; k < 3; ++k) {
+			added += (local[indices[i + k]] == unused) &&
+					 std::find(&indices[i], &indices[i + k], indices[i + k]) == &indices[i + k];
+		}
+		if(current.vertex_count + added > max_vertices || current.triangle_count + 1 > max_triangles)
+			finish();
+
+		for(size_t k = 0; k < 3; ++k) {
+			auto& vertex = local[indices[i + k]];
+			if(vertex == unused) {
+				vertex = current.vertex_count++;
+				result.vertices.emplace_back(indices[i + k]);
+			}
+			result.triangles.emplace_back(static_cast<uint8_t>(vertex));
+		}
+		++current.triangle_count;
+	}
+	finish();
+	return result;
+}
+
+bounding_volume_t compute_bounding_volume(std::span<float const> positions) {
+	bounding_volume_t result {};
+	auto const count = positions.size() / 3;
+	if(count == 0)
+		return result;
+
+	// plain per axis reductions without branches, so the compiler can vectorize them
+	std::array<float, 3> min {positions[0], positions[1], positions[2]}, max = min;
+	for(size_t i = 0; i < count * 3; i += 3) {
+		for(size_t axis = 0; axis < 3; ++axis) {
+			min[axis] = std::min(min[axis], positions[i + axis]);
+			max[axis] = std::max(max[axis], positions[i + axis]);
+		}
+	}
+	result.min = min;
+	result.max = max;
+
+	auto const position = [&positions](size_t vertex) {
+		return std::array<double, 3> {positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]};
+	};
+	auto const farthest = [&](std::array<double, 3> const& from) {
+		size_t index {0};
+		double distance {-1.0};
+		for(size_t vertex = 0; vertex < count; ++vertex) {
+			auto const offset = subtract(position(vertex), from);
+			if(auto const value = dot(offset, offset); value > distance) {
+				distance = value;
+				index	 = vertex;
+			}
+		}
+		return position(index);
+	};
+
+	// Ritter: start with the sphere through two far apart vertices, and grow it to contain the vertices outside of it
+	auto const first  = farthest(position(0));
+	auto const second = farthest(first);
+	std::array<double, 3> center {
+	  (first[0] + second[0]) / 2.0, (first[1] + second[1]) / 2.0, (first[2] + second[2]) / 2.0};
+	auto const diameter = subtract(second, first);
+	double radius		= std::sqrt(dot(diameter, diameter)) / 2.0;
+	for(size_t vertex = 0; vertex < count; ++vertex) {
+		auto const offset	= subtract(position(vertex), center);
+		auto const distance = std::sqrt(dot(offset, offset));
+		if(distance <= radius)
+			continue;
+		auto const grown = (radius + distance) / 2.0;
+		for(size_t axis = 0; axis < 3; ++axis) center[axis] += offset[axis] * (grown - radius) / distance;
+		radius = grown;
+	}
+
+	// the sphere around the bounds is tighter for box like shapes
+	std::array<double, 3> box_center {(static_cast<double>(min[0]) + max[0]) / 2.0,
+									  (static_cast<double>(min[1]) + max[1]) / 2.0,
+									  (static_cast<double>(min[2]) + max[2]) / 2.0};
+	double box_radius = 0.0;
+	for(size_t vertex = 0; vertex < count; ++vertex) {
+		auto const offset = subtract(position(vertex), box_center);
+		box_radius		  = std::max(box_radius, dot(offset, offset));
+	}
+	if(box_radius = std::sqrt(box_radius); box_radius < radius) {
+		center = box_center;
+		radius = box_radius;
+	}
+
+	for(size_t axis = 0; axis < 3; ++axis) result.center[axis] = static_cast<float>(center[axis]);
+	// rounded up, so the vertices stay inside the sphere after the conversion to float
+	result.radius = std::nextafter(static_cast<float>(radius), std::numeric_limits<float>::infinity());
+	return result;
+}
+
+size_t simplify(std::span<uint32_t> destination,
+				std::span<uint32_t const> indices,
+				std::span<psl::vec3 const> positions,
+				std::span<float const> attributes,
+				size_t attribute_count,
+				size_t target_index_count,
+				float target_error,
+				float& result_error) {
+	auto const vertex_count = positions.size();
+	result_error			= 0.0f;
+	std::copy(std::begin(indices), std::end(indices), std::begin(destination));
+	size_t index_count = indices.size();
+	if(index_count <= target_index_count || vertex_count == 0)
+		return index_count;
+
+	// the positions are normalized to the bounds, so the errors are relative to the size of the mesh
+	std::array<double, 3> min {}, max {};
+	for(size_t axis = 0; axis < 3; ++axis) {
+		min[axis] = max[axis] = positions[0][axis];
+	}
+	for(auto const& position : positions) {
+		for(size_t axis = 0; axis < 3; ++axis) {
+			min[axis] = std::min<double>(min[axis], position[axis]);
+			max[axis] = std::max<double>(max[axis], position[axis]);
+		}
+	}
+	auto const extent = std::max({max[0] - min[0], max[1] - min[1], max[2] - min[2], 1e-12});
+	psl::array<std::array<double, 3>> points(vertex_count);
+	for(size_t v = 0; v < vertex_count; ++v) {
+		for(size_t axis = 0; axis < 3; ++axis) points[v][axis] = (positions[v][axis] - min[axis]) / extent;
+	}
+
+	// vertices that share a position (UV seams, hard normals, ...) are wedges of the same welded vertex, they share a
+	// quadric and are collapsed together. Welded vertices on a border or non-manifold edge are locked in place.
+	psl::array<uint32_t> welded(vertex_count);
+	psl::array<uint32_t> next_wedge(vertex_count);	  // circular list of the wedges of a welded vertex
+	psl::array<uint8_t> locked(vertex_count, 0);	  // indexed by welded vertex
+	{
+		std::unordered_map<uint64_t, psl::array<uint32_t>> buckets {};
+		auto const hash = [&positions](uint32_t v) {
+			uint64_t result = 0;
+			for(size_t axis = 0; axis < 3; ++axis) {
+				float const value = positions[v][axis];
+				uint32_t bits {};
+				std::memcpy(&bits, &value, sizeof(bits));
+				result = result * 0x9E3779B97F4A7C15ull + bits;
+			}
+			return result;
+		};
+		for(uint32_t v = 0; v < vertex_count; ++v) {
+			welded[v]	  = v;
+			next_wedge[v] = v;
+			auto& bucket  = buckets[hash(v)];
+			for(auto other : bucket) {
+				if(points[other] == points[v]) {
+					welded[v]		  = welded[other];
+					next_wedge[v]	  = next_wedge[other];
+					next_wedge[other] = v;
+					break;
+				}
+			}
+			bucket.emplace_back(v);
+		}
+
+		std::unordered_map<uint64_t, uint32_t> edges {};
+		for(size_t i = 0; i < index_count; i += 3) {
+			for(size_t e = 0; e < 3; ++e) {
+				uint64_t a = welded[indices[i + e]];
+				uint64_t b = welded[indices[i + (e + 1) % 3]];
+				++edges[(std::min(a, b) << 32) | std::max(a, b)];
+			}
+		}
+		for(auto const& [edge, count] : edges) {
+			if(count != 2) {
+				locked[edge >> 32]		   = 1;
+				locked[edge & 0xFFFFFFFFu] = 1;
+			}
+		}
+	}
+
+	psl::array<quadric_t> quadrics(vertex_count);	 // indexed by welded vertex
+	for(size_t i = 0; i < index_count; i += 3) {
+		auto const& p0	   = points[indices[i]];
+		auto normal		   = cross(subtract(points[indices[i + 1]], p0), subtract(points[indices[i + 2]], p0));
+		auto const length = std::sqrt(dot(normal, normal));
+		if(length <= 0.0)
+			continue;
+		for(auto& value : normal) value /= length;
+		auto const quadric = quadric_t::plane(normal[0], normal[1], normal[2], -dot(normal, p0), length * 0.5);
+		for(size_t k = 0; k < 3; ++k) quadrics[welded[indices[i + k]]] += quadric;
+	}
+
+	auto attribute_error = [&attributes, attribute_count](uint32_t from, uint32_t to) {
+		double result = 0.0;
+		for(size_t a = 0; a < attribute_count; ++a) {
+			double const difference = attributes[from * attribute_count + a] - attributes[to * attribute_count + a];
+			result += difference * difference;
+		}
+		return result;
+	};
+
+	// collapsing `from` into `to` should not flip any of the remaining triangles around `from`
+	auto flips = [&](adjacency_t const& adjacency, uint32_t from, uint32_t to) {
+		for(uint32_t j = 0; j < adjacency.counts[from]; ++j) {
+			auto const t = adjacency.triangles[adjacency.offsets[from] + j];
+			auto const triangle = destination.subspan(t * 3, 3);
+			if(std::any_of(
+				 std::begin(triangle), std::end(triangle), [&](uint32_t v) { return welded[v] == welded[to]; }))
+				continue;
+			std::array<std::array<double, 3>, 3> corners {points[triangle[0]], points[triangle[1]], points[triangle[2]]};
+			auto const before = cross(subtract(corners[1], corners[0]), subtract(corners[2], corners[0]));
+			for(size_t k = 0; k < 3; ++k) {
+				if(triangle[k] == from)
+					corners[k] = points[to];
+			}
+			auto const after = cross(subtract(corners[1], corners[0]), subtract(corners[2], corners[0]));
+			if(dot(before, after) <= 0.0)
+				return true;
+		}
+		return false;
+	};
+
+	// every wedge of `from` has to move along an edge to a wedge of `to`, otherwise the collapse would tear the seam
+	auto find_target = [&](adjacency_t const& adjacency, uint32_t from, uint32_t to) {
+		for(uint32_t j = 0; j < adjacency.counts[from]; ++j) {
+			auto const t = adjacency.triangles[adjacency.offsets[from] + j];
+			for(size_t k = 0; k < 3; ++k) {
+				if(welded[destination[t * 3 + k]] == welded[to])
+					return destination[t * 3 + k];
+			}
+		}
+		return std::numeric_limits<uint32_t>::max();
+	};
+
+	struct collapse_t {
+		uint32_t from;
+		uint32_t to;
+		double cost;
+		double error;
+	};
+
+	auto const error_limit = static_cast<double>(target_error) * static_cast<double>(target_error);
+	double max_error	   = 0.0;
+	psl::array<uint32_t> remap(vertex_count);
+	psl::array<uint8_t> touched(vertex_count);
+	psl::array<collapse_t> collapses {};
+	psl::array<std::pair<uint32_t, uint32_t>> moves {};
+	while(index_count > target_index_count) {
+		collapses.clear();
+		for(size_t i = 0; i < index_count; i += 3) {
+			for(size_t e = 0; e < 3; ++e) {
+				auto const a = destination[i + e];
+				auto const b = destination[i + (e + 1) % 3];
+				for(auto [from, to] : {std::pair {a, b}, std::pair {b, a}}) {
+					if(locked[welded[from]] || welded[from] == welded[to])
+						continue;
+					// the quadric of the merged vertex, the mean squared distance to the planes of both vertices
+					auto const error = (quadrics[welded[from]] + quadrics[welded[to]]).error(points[to]);
+					if(error <= error_limit)
+						collapses.emplace_back(collapse_t {from, to, error + attribute_error(from, to), error});
+				}
+			}
+		}
+		std::sort(std::begin(collapses), std::end(collapses), [](collapse_t const& lhs, collapse_t const& rhs) {
+			return lhs.cost < rhs.cost;
+		});
+
+		// every collapse removes (about) two triangles, vertices around a collapse are not touched again in this pass
+		// as the flip test would no longer be valid
+		auto const adjacency = build_adjacency(destination.first(index_count), vertex_count);
+		auto const budget	 = std::max<size_t>(1u, (index_count - target_index_count) / 6);
+		std::iota(std::begin(remap), std::end(remap), 0u);
+		std::fill(std::begin(touched), std::end(touched), uint8_t {0});
+		size_t collapsed = 0;
+		for(auto const& collapse : collapses) {
+			moves.clear();
+			bool valid = true;
+			auto wedge = collapse.from;
+			do {
+				auto const target = (wedge == collapse.from) ? collapse.to : find_target(adjacency, wedge, collapse.to);
+				if(adjacency.counts[wedge] > 0) {
+					valid &= target != std::numeric_limits<uint32_t>::max() && !touched[wedge] && !touched[target] &&
+							 !flips(adjacency, wedge, target);
+					moves.emplace_back(wedge, target);
+				}
+				wedge = next_wedge[wedge];
+			} while(valid && wedge != collapse.from);
+			if(!valid)
+				continue;
+
+			for(auto [from, to] : moves) {
+				for(uint32_t j = 0; j < adjacency.counts[from]; ++j) {
+					auto const t = adjacency.triangles[adjacency.offsets[from] + j];
+					for(size_t k = 0; k < 3; ++k) touched[destination[t * 3 + k]] = 1;
+				}
+				remap[from] = to;
+			}
+			quadrics[welded[collapse.to]] += quadrics[welded[collapse.from]];
+			max_error = std::max(max_error, collapse.error);
+			if(++collapsed >= budget)
+				break;
+		}
+		if(collapsed == 0)
+			break;
+
+		size_t write = 0;
+		for(size_t i = 0; i < index_count; i += 3) {
+			auto const a = remap[destination[i]];
+			auto const b = remap[destination[i + 1]];
+			auto const c = remap[destination[i + 2]];
+			// wedges of the same welded vertex share their position, so such triangles have no area left
+			if(welded[a] == welded[b] || welded[b] == welded[c] || welded[a] == welded[c])
+				continue;
+			destination[write++] = a;
+			destination[write++] = b;
+			destination[write++] = c;
+		}
+		index_count = write;
+	}
+
+	result_error = static_cast<float>(std::sqrt(max_error));
+	return index_count;
+}
+}	 // namespace tools
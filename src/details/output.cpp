@@ -0,0 +1,55 @@
+#include "details/output.hpp"
+#include "psl/platform_utils.hpp"
+#include "stdafx.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace assembler {
+namespace {
+	std::atomic<size_t> written {0};
+	std::atomic<size_t> unchanged {0};
+
+	bool has_content(psl::string const& path, psl::string8::view content) {
+		auto const platform_path = psl::utility::platform::file::to_platform(path);
+		std::error_code error {};
+		if(auto size = std::filesystem::file_size(platform_path, error); error || size != content.size())
+			return false;
+
+		// compare in chunks, so large outputs are never loaded in their entirety
+		std::ifstream file {platform_path, std::ios::binary};
+		std::array<char, 64 * 1024> buffer;
+		for(size_t offset = 0; offset < content.size();) {
+			auto const count = std::min(buffer.size(), content.size() - offset);
+			if(!file.read(buffer.data(), count) || std::memcmp(buffer.data(), content.data() + offset, count) != 0)
+				return false;
+			offset += count;
+		}
+		return true;
+	}
+}	 // namespace
+
+bool write_if_changed(psl::string const& path, psl::string8::view content) {
+	if(has_content(path, content)) {
+		++unchanged;
+		return true;
+	}
+	++written;
+	return psl::utility::platform::file::write(path, content);
+}
+
+write_statistics_t write_statistics() noexcept {
+	return {written.load(), unchanged.load()};
+}
+
+void log_write_statistics(write_statistics_t const& since) {
+	auto const current = write_statistics();
+	if(current.unchanged > since.unchanged)
+		assembler::log->info("{0} outputs were identical and not rewritten, {1} were written\n",
+							 current.unchanged - since.unchanged,
+							 current.written - since.written);
+}
+}	 // namespace assembler
@@ -6,12 +6,19 @@
 #include "psl/ustring.hpp"
 #include "psl/string_utils.hpp"
 
+#include <future>
+
 #include <SPIRV/GlslangToSpv.h>
+#include <spirv-tools/optimizer.hpp>
 #include <spirv_reflect.hpp>
 #include <spirv_glsl.hpp>
 #include <glslang/Include/glslang_c_interface.h>
 #include <glslang/Public/resource_limits_c.h>
-tools::_internal::glslang_manager_t tools::_internal::glslang_manager {};
+#include <spirv_parser.hpp>
+
+#if defined(AS_ENABLE_WGSL)
+	#include "tint/tint.h"
+#endif
 
 namespace tools {
 namespace _internal {
@@ -21,6 +28,10 @@ namespace _internal {
 	glslang_manager_t::~glslang_manager_t() {
 		glslang_finalize_process();
 	}
+	glslang_manager_t& glslang_manager() {
+		static glslang_manager_t manager {};
+		return manager;
+	}
 }	 // namespace _internal
 
 constexpr glslang_stage_t get_stage(shader_stage_t stage) {
@@ -42,10 +53,8 @@ constexpr glslang_stage_t get_stage(shader_stage_t stage) {
 	}
 }
 
-bool reflect_spirv(glsl_compile_result_t& result) {
-	auto spirv_data = (const uint32_t*)result.spirv.data();
-	auto spirv_size = result.spirv.size() / sizeof(uint32_t);
-	spirv_cross::CompilerReflection module(spirv_data, spirv_size);
+bool reflect_spirv(spirv_cross::ParsedIR&& ir, glsl_compile_result_t& result) {
+	spirv_cross::CompilerReflection module(std::move(ir));
 	auto const& resources = module.get_shader_resources();
 
 	auto parse_attributes = [&module,
@@ -273,8 +282,8 @@ bool compileShaderToSPIRV_Vulkan(glslang_stage_t stage, char const* shaderSource
 	}
 
 	glslang_program_SPIRV_generate(program, stage);
-	result.spirv.resize(glslang_program_SPIRV_get_size(program) * sizeof(uint32_t));
-	glslang_program_SPIRV_get(program, (uint32_t*)(result.spirv.data()));
+	result.spirv.words.resize(glslang_program_SPIRV_get_size(program));
+	glslang_program_SPIRV_get(program, result.spirv.data());
 
 	char const* spirv_messages = glslang_program_SPIRV_get_messages(program);
 	if (spirv_messages) {
@@ -286,10 +295,87 @@ bool compileShaderToSPIRV_Vulkan(glslang_stage_t stage, char const* shaderSource
 
 	return true;
 }
+size_t instruction_count(uint32_t const* words, size_t size) noexcept {
+	// the first 5 words are the module header, every instruction encodes its word count in the upper 16 bits
+	size_t count = 0;
+	for(size_t offset = 5; offset < size; ++count) {
+		auto const length = words[offset] >> 16;
+		if(length == 0)
+			break;
+		offset += length;
+	}
+	return count;
+}
+
+bool optimize_spirv(optimization_t optimize, glsl_compile_result_t& result) {
+	result.unoptimized = {instruction_count(result.spirv.data(), result.spirv.size()), result.spirv.bytes().size()};
+
+	spvtools::Optimizer optimizer {SPV_ENV_VULKAN_1_3};
+	optimizer.SetMessageConsumer(
+	  [&result](spv_message_level_t level, char const*, spv_position_t const& position, char const* message) {
+		  result.messages.emplace_back(fmt::format("spirv-opt: {} (at word {})", message, position.index),
+									   level <= SPV_MSG_ERROR);
+	  });
+	if(optimize == optimization_t::size)
+		optimizer.RegisterSizePasses();
+	else
+		optimizer.RegisterPerformancePasses();
+
+	std::vector<uint32_t> optimized {};
+	if(!optimizer.Run(result.spirv.data(), result.spirv.size(), &optimized)) {
+		result.messages.emplace_back("spirv-opt failed to optimize the module", true);
+		return false;
+	}
+
+	result.spirv.words = std::move(optimized);
+	result.optimized   = {instruction_count(result.spirv.data(), result.spirv.size()), result.spirv.bytes().size()};
+	return true;
+}
+
+struct backend_result_t {
+	psl::string8_t output {};
+	psl::array<glsl_compile_result_t::message_t> messages {};
+	bool success {true};
+};
+
+backend_result_t compile_gles(spirv_cross::CompilerGLSL& compiler, size_t version) {
+	spirv_cross::CompilerGLSL::Options options;
+	options.version = version;
+	options.es		= true;
+	compiler.set_common_options(options);
+
+	return {compiler.compile()};
+}
+
+#if defined(AS_ENABLE_WGSL)
+backend_result_t compile_wgsl(spirv_t const& source) {
+	backend_result_t result {};
+	auto spirvReadOption = tint::spirv::reader::Options {};
+	auto tintIr			 = tint::spirv::reader::Read(source.words, spirvReadOption);
+	if(tintIr.Diagnostics().contains_errors()) {
+		result.messages.emplace_back(
+		  fmt::format("failed to convert the spirv to tint-ir: {}", tintIr.Diagnostics().str()), true);
+		result.success = false;
+		return result;
+	}
+	auto wgslOptions = tint::wgsl::writer::Options();
+	auto tintWgslRes = tint::wgsl::writer::Generate(tintIr, wgslOptions);
+	if(tintWgslRes != tint::Success) {
+		result.messages.emplace_back(
+		  fmt::format("failed to convert the tint-ir to wgsl: {}", tintWgslRes.Failure().reason.str()), true);
+		result.success = false;
+		return result;
+	}
+	result.output = tintWgslRes.Move().wgsl;
+	return result;
+}
+#endif
+
 	glsl_compile_result_t
-glsl_compile(psl::string_view source, shader_stage_t type, bool optimize, std::optional<size_t> gles_version) {
+glsl_compile(psl::string_view source, shader_stage_t type, optimization_t optimize, std::optional<size_t> gles_version) {
 	auto const stage = get_stage(type);
 	glsl_compile_result_t result {true};
+	_internal::glslang_manager();
 	if(stage == glslang_stage_t::GLSLANG_STAGE_COUNT) {
 		result.messages.emplace_back(fmt::format("unknown shader_stage_t value '{}'", std::to_underlying(type)), true);
 		result.success = false;
@@ -300,18 +386,45 @@ glsl_compile(psl::string_view source, shader_stage_t type, bool optimize, std::o
 		return result;
 	}
 
-	if(gles_version) {
-		spirv_cross::CompilerGLSL gles_compiler((const uint32_t*)result.spirv.data(), result.spirv.size() / sizeof(uint32_t));
+	// the other backends are generated from the optimized module, so they benefit from it as well
+	if(optimize != optimization_t::none && !optimize_spirv(optimize, result)) {
+		result.success = false;
+		return result;
+	}
 
-		spirv_cross::CompilerGLSL::Options options;
-		options.version = gles_version.value();
-		options.es		= true;
-		gles_compiler.set_common_options(options);
+	// the module is parsed only once, the GLES compiler gets a copy of the IR and the reflection takes ownership of it.
+	// all backends only read from the SPIR-V, so they can run concurrently, each with its own messages.
+	spirv_cross::Parser parser(result.spirv.data(), result.spirv.size());
+	parser.parse();
+	auto& ir = parser.get_parsed_ir();
 
-		result.gles = gles_compiler.compile();
+	std::future<backend_result_t> gles {};
+	if(gles_version) {
+		gles = std::async(std::launch::async,
+						  [compiler = std::make_unique<spirv_cross::CompilerGLSL>(ir), version = gles_version.value()]() {
+							  return compile_gles(*compiler, version);
+						  });
 	}
+#if defined(AS_ENABLE_WGSL)
+	auto wgsl = std::async(std::launch::async, [&result]() { return compile_wgsl(result.spirv); });
+#endif
+
+	auto const reflected = reflect_spirv(std::move(ir), result);
+
+	auto gather = [&result](std::future<backend_result_t>& backend, psl::string8_t& output) {
+		if(!backend.valid())
+			return;
+		auto value = backend.get();
+		output	   = std::move(value.output);
+		result.messages.append_range(std::move(value.messages));
+		result.success &= value.success;
+	};
+	gather(gles, result.gles);
+#if defined(AS_ENABLE_WGSL)
+	gather(wgsl, result.wgsl);
+#endif
 
-	if(!reflect_spirv(result)) {
+	if(!reflected) {
 		result.success = false;
 		result.shader  = {};
 		return result;
@@ -1,12 +1,25 @@
 ﻿#include "generators/models.h"
 #include "cli/value.h"
+#include "details/geometry_file.hpp"
+#include "details/mesh_optimizer.hpp"
+#include "details/output.hpp"
+#include "details/parallel.hpp"
 #include "psl/library.hpp"
 #include "psl/math/math.hpp"
 #include "psl/meta.hpp"
 #include "psl/serialization/serializer.hpp"
 #include "psl/terminal_utils.hpp"
 #include "stdafx.h"
+#include "utils.h"
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <filesystem>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_set>
 #ifdef DBG_NEW
 	#undef new
 #endif
@@ -33,29 +46,194 @@ template <typename T>
 using cli_value = psl::cli::value<T>;
 using namespace psl;
 
+namespace details {
+// sidecar of a geometry file, with the meshlets of its indices (see `tools::build_meshlets`)
+struct meshlets_data_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << vertices << triangles << meshlets << bounds;
+	}
+
+	static constexpr char const serialization_name[9] {"MESHLETS"};
+	psl::serialization::property<"VERTICES", psl::array<uint32_t>> vertices;
+	psl::serialization::property<"TRIANGLES", psl::array<uint8_t>> triangles;
+	// vertex offset, vertex count, triangle offset and triangle count of every meshlet
+	psl::serialization::property<"MESHLETS", psl::array<uint32_t>> meshlets;
+	// center (3), radius, cone apex (3), cone axis (3) and cone cutoff of every meshlet
+	psl::serialization::property<"BOUNDS", psl::array<float>> bounds;
+};
+}	 // namespace details
+
 constexpr psl::string_view MODEL_FORMAT		= "pgf";
+constexpr psl::string_view GEOMETRY_FORMAT	= "pgb";	// memory mappable geometry, see `tools::geometry_file_t`
+constexpr psl::string_view MESHLET_FORMAT	= "pml";
+
+// the largest index is reserved for primitive restart
+constexpr size_t MAX_16BIT_VERTICES = std::numeric_limits<uint16_t>::max();
 constexpr psl::string_view SKELETON_FORMAT	= "psf";
 constexpr psl::string_view ANIMATION_FORMAT = "paf";
 
+// the squared attribute differences are weighed against the squared geometric error (relative to the mesh size) when
+// simplifying the LODs
+constexpr float LOD_NORMAL_WEIGHT = 0.5f;
+constexpr float LOD_UV_WEIGHT	  = 1.0f;
+
 models::models() {
 	m_Pack =
 	  psl::cli::pack {std::bind(&assembler::generators::models::on_invoke, this, std::placeholders::_1),
-					  cli_value<psl::string> {"input", "location of the input file", {"input", "i"}, "", false},
+					  cli_value<psl::string> {"input",
+											  "location of the input file, or a directory when ending with '*'",
+											  {"input", "i"},
+											  "",
+											  false},
 					  cli_value<psl::string> {"output", "location of the output file", {"output", "o"}, "", true},
 					  cli_value<bool> {"tangents", "generate tangent information", {"tangents", "t"}, true},
 					  cli_value<bool> {"normals", "generate normal information", {"normals", "n"}, true},
 					  cli_value<bool> {"snormals", "generate smooth normal information", {"snormals", "s"}, true},
 					  cli_value<bool> {"uvs", "generate uv information", {"uvs"}, true},
 					  cli_value<bool> {"optimize", "optimize the mesh", {"optimize", "O"}, true},
+					  cli_value<bool> {"reorder",
+									   "reorder the triangles for the post-transform vertex cache and overdraw",
+									   {"reorder", "r"},
+									   false,
+									   true},
+					  cli_value<std::vector<float>> {"lods",
+													 "triangle ratios of the LODs to generate for every mesh, f.e. "
+													 "'0.5 0.25 0.125' (empty to disable)",
+													 {"lods"},
+													 std::vector<float> {},
+													 true},
+					  cli_value<float> {"lod error",
+										"maximum error a LOD may introduce, relative to the size of the mesh",
+										{"lod-error"},
+										0.01f,
+										true},
+					  cli_value<bool> {"quantize",
+									   "quantize the vertex streams and write them as 'pgb' instead of 'pgf'",
+									   {"quantize", "q"},
+									   false,
+									   true},
+					  cli_value<bool> {"mappable",
+									   "write the geometry as 'pgb' instead of 'pgf', which can be memory mapped and "
+									   "uploaded without parsing",
+									   {"pgb"},
+									   false,
+									   true},
+					  cli_value<bool> {"interleave",
+									   "interleave the vertex streams in a single buffer, written as 'pgb'",
+									   {"interleave"},
+									   false,
+									   true},
+					  cli_value<bool> {"interleave hybrid",
+									   "keep the positions in their own buffer, and interleave the other streams in a "
+									   "second buffer, written as 'pgb'",
+									   {"interleave-hybrid"},
+									   false,
+									   true},
+					  cli_value<size_t> {"alignment",
+										 "alignment in bytes of the interleaved attributes and strides",
+										 {"alignment"},
+										 4,
+										 true},
+					  cli_value<bool> {"split",
+									   "split meshes with more vertices than 16bit indices can address into parts, only "
+									   "the 'pgb' output stores 16bit indices so this needs '--pgb', '--quantize' or "
+									   "'--interleave'",
+									   {"split"},
+									   false,
+									   true},
+					  cli_value<bool> {"meshlets",
+									   "write the meshlets of every mesh, with their culling bounds, as 'pml'",
+									   {"meshlets"},
+									   false,
+									   true},
+					  cli_value<size_t> {"meshlet vertices",
+										 "maximum amount of vertices of a meshlet (up to 256)",
+										 {"meshlet-vertices"},
+										 64,
+										 true},
+					  cli_value<size_t> {"meshlet triangles",
+										 "maximum amount of triangles of a meshlet",
+										 {"meshlet-triangles"},
+										 124,
+										 true},
 					  cli_value<bool> {"LH", "left handed coordinate system", {"LH"}, true},
 					  cli_value<bool> {"fuvs", "flip uv coorinates", {"fuvs"}, false},
 					  cli_value<bool> {"fwinding", "flip triangle winding", {"fwinding"}, false},
 					  cli_value<bool> {"flatten", "", {"flatten", "f"}, false},
 					  cli_value<psl::string> {"axis", "what should be left, up, and forward?", {"axis"}, "xzy"},
 					  cli_value<bool> {"sparse_skeleton", "compress the skeleton information", {"sparse"}, true},
-					  cli_value<bool> {"binary", "outputs the file in binary form", {"bin", "b"}, false}};
+					  cli_value<bool> {"binary", "outputs the file in binary form", {"bin", "b"}, false},
+					  cli_value<size_t> {"jobs",
+										 "amount of files (and meshes) that are processed concurrently, 0 uses all "
+										 "available cores",
+										 {"jobs", "j"},
+										 1,
+										 true},
+					  cli_value<size_t> {"memory",
+										 "estimated amount of memory (in MiB) the concurrently imported scenes are "
+										 "allowed to use, 0 for no limit",
+										 {"memory"},
+										 4096,
+										 true},
+					  cli_value<psl::string> {"cache",
+											  "directory of the action cache, only the input file itself is part of "
+											  "the key, not the files it references (empty to disable)",
+											  {"cache"},
+											  "",
+											  true}};
 }
 
+// assimp's logger is a process wide singleton, imports that run concurrently (see `assembler::batch`) have to share it
+class assimp_logger_scope {
+  public:
+	assimp_logger_scope() {
+		std::lock_guard lock {m_Mutex};
+		if(m_Users++ == 0)
+			Assimp::DefaultLogger::create("", Assimp::Logger::VERBOSE);
+	}
+	~assimp_logger_scope() {
+		std::lock_guard lock {m_Mutex};
+		if(--m_Users == 0)
+			Assimp::DefaultLogger::kill();
+	}
+
+  private:
+	static inline std::mutex m_Mutex {};
+	static inline size_t m_Users {0};
+};
+
+// assimp scenes take up a multiple of the size of the file they were loaded from, this is a rough upper bound used to
+// estimate how many scenes can be imported at the same time.
+constexpr size_t SCENE_MEMORY_FACTOR = 10;
+
+// bounds the files that are imported concurrently by their estimated memory usage. A scene that exceeds the budget on
+// its own is still imported, but only once nothing else is in flight.
+class scene_budget {
+  public:
+	scene_budget(size_t budget) : m_Budget(budget) {}
+
+	void acquire(size_t size) {
+		std::unique_lock lock {m_Mutex};
+		m_Condition.wait(lock, [this, size]() { return m_Budget == 0 || m_Used == 0 || m_Used + size <= m_Budget; });
+		m_Used += size;
+	}
+	void release(size_t size) {
+		{
+			std::lock_guard lock {m_Mutex};
+			m_Used -= size;
+		}
+		m_Condition.notify_all();
+	}
+
+  private:
+	std::mutex m_Mutex {};
+	std::condition_variable m_Condition {};
+	size_t m_Budget {0};
+	size_t m_Used {0};
+};
+
 bool proccess_flags(cli::pack& pack, unsigned int& flags) {
 	flags = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType |
 			aiProcess_ValidateDataStructure | aiProcess_OptimizeGraph;
@@ -83,8 +261,41 @@ bool proccess_flags(cli::pack& pack, unsigned int& flags) {
 	return true;
 }
 
+// extra values that get added to the META node of the meta file
+using meta_properties_t = psl::array<std::pair<psl::string, psl::string>>;
+
+// writes the meta file of `output_file`, keeping the UID of the meta file that is already there
+bool write_meta_file(psl::string const& output_file, meta_properties_t const& properties = {}) {
+	auto output_meta = output_file + "." + psl::from_string8_t(meta::META_EXTENSION);
+	UID uid			 = UID::generate();
+	if(utility::platform::file::exists(output_meta)) {
+		::meta::file* original = nullptr;
+		serialization::serializer temp_s;
+		temp_s.deserialize<serialization::decode_from_format>(original, output_meta);
+		uid = original->ID();
+	}
+
+	meta::file metaFile {uid};
+	format::container cont {};
+	serialization::serializer s;
+	s.serialize<serialization::encode_to_format>(metaFile, cont);
+	if(!properties.empty()) {
+		auto metaNode = cont.find("META");
+		for(auto const& [name, value] : properties) cont.add_value(metaNode.get(), name, value);
+	}
+	if(!assembler::write_if_changed(output_meta, cont.to_string())) {
+		assembler::log->error("could not write the output file.");
+		return false;
+	}
+	return true;
+}
+
 template <typename T>
-bool write_meta(T& data, psl::string output_file, psl::string_view const& extension, bool binary) {
+bool write_meta(T& data,
+				psl::string output_file,
+				psl::string_view const& extension,
+				bool binary,
+				meta_properties_t const& properties = {}) {
 	format::container cont {};
 	format::settings settings {};
 	if(binary) {
@@ -96,38 +307,315 @@ bool write_meta(T& data, psl::string output_file, psl::string_view const& extens
 
 	s.serialize<serialization::encode_to_format>(data, cont);
 	output_file += "." + extension;
-	auto output_meta = output_file + "." + psl::from_string8_t(meta::META_EXTENSION);
 
-	if(!utility::platform::file::write(output_file, cont.to_string())) {
+	if(!assembler::write_if_changed(output_file, cont.to_string())) {
 		assembler::log->error("could not write the output file.");
 		return false;
 	}
+	return write_meta_file(output_file, properties);
+}
 
-	{
-		UID uid = UID::generate();
-		if(utility::platform::file::exists(output_meta)) {
-			::meta::file* original = nullptr;
-			serialization::serializer temp_s;
-			temp_s.deserialize<serialization::decode_from_format>(original, output_meta);
-			uid = original->ID();
+using indices_t = std::decay_t<decltype(std::declval<geometry_t&>().indices())>;
+
+// strides of the buffers that `write_geometry` writes
+psl::array<size_t> geometry_strides(aiMesh* pAIMesh, models::settings_t const& settings) {
+	auto const quantize	 = settings.quantize;
+	auto const direction = quantize ? 2 * sizeof(int16_t) : sizeof(psl::vec3);
+	psl::array<size_t> strides {quantize ? 4 * sizeof(uint16_t) : sizeof(psl::vec3)};
+	if(pAIMesh->HasNormals())
+		strides.emplace_back(direction);
+	if(pAIMesh->HasTangentsAndBitangents())
+		strides.insert(std::end(strides), 2, direction);
+	for(uint32_t uvChannel = 0; uvChannel < pAIMesh->GetNumUVChannels(); ++uvChannel) {
+		if(pAIMesh->HasTextureCoords(uvChannel))
+			strides.emplace_back(quantize ? 2 * sizeof(uint16_t) : sizeof(psl::vec2));
+	}
+	for(unsigned int c = 0; c < pAIMesh->GetNumColorChannels(); ++c) {
+		if(pAIMesh->HasVertexColors(c))
+			strides.emplace_back(quantize ? 4 * sizeof(uint8_t) : sizeof(psl::vec4));
+	}
+	auto const layout = tools::layout_streams(strides, settings.layout, settings.alignment);
+	return psl::array<size_t>(std::begin(layout.strides), std::end(layout.strides));
+}
+
+// reorders the triangles and the vertices for the GPU, returns the new vertex order (new vertex to assimp's vertex)
+psl::array<uint32_t> optimize_geometry(aiMesh* pAIMesh,
+									   indices_t& indices,
+									   psl::array<psl::vec3> const& positions,
+									   psl::string const& name,
+									   models::settings_t const& settings) {
+	auto const before = tools::analyze_vertex_cache(indices, positions.size());
+	tools::optimize_vertex_cache(indices, positions.size());
+	tools::optimize_overdraw(indices, positions);
+	auto const after = tools::analyze_vertex_cache(indices, positions.size());
+	assembler::log->info("reordered the triangles of '{0}', ACMR {1:.3f} -> {2:.3f}, ATVR {3:.3f} -> {4:.3f}",
+						 name,
+						 before.acmr(),
+						 after.acmr(),
+						 before.atvr(),
+						 after.atvr());
+
+	auto const strides		= geometry_strides(pAIMesh, settings);
+	auto const fetch_before = tools::analyze_vertex_fetch(indices, positions.size(), strides);
+	auto order				= tools::optimize_vertex_fetch(indices, positions.size());
+	auto const fetch_after	= tools::analyze_vertex_fetch(indices, order.size(), strides);
+	assembler::log->info(
+	  "remapped the vertices of '{0}', fetch hit ratio {1:.3f} -> {2:.3f}, dropped {3} unused vertices",
+	  name,
+	  fetch_before.hit_ratio(),
+	  fetch_after.hit_ratio(),
+	  positions.size() - order.size());
+	return order;
+}
+
+enum class attribute_t : uint8_t { position, direction, uv, color };
+
+// a single vertex attribute of the mesh, `components` floats per vertex
+struct attribute_stream_t {
+	psl::string name {};
+	attribute_t attribute {attribute_t::position};
+	uint8_t components {0};
+	psl::array<float> values {};
+};
+
+// gathers the attributes in the given vertex order (new vertex to assimp's vertex), so they all stay in sync
+psl::array<attribute_stream_t>
+gather_attributes(aiMesh* pAIMesh, psl::array<uint32_t> const& order, std::array<uint8_t, 3> axis_setup) {
+	psl::array<attribute_stream_t> result {};
+	auto add_vectors = [&](psl::string name, attribute_t attribute, aiVector3D const* source) {
+		auto& stream = result.emplace_back(attribute_stream_t {std::move(name), attribute, 3, {}});
+		stream.values.reserve(order.size() * 3);
+		for(auto index : order) {
+			std::array<float, 3> value {
+			  source[index][axis_setup[0]], source[index][axis_setup[1]], source[index][axis_setup[2]]};
+			if(attribute == attribute_t::direction) {
+				auto const length = std::sqrt(value[0] * value[0] + value[1] * value[1] + value[2] * value[2]);
+				if(length > 0.0f) {
+					for(auto& component : value) component /= length;
+				}
+			}
+			stream.values.insert(std::end(stream.values), std::begin(value), std::end(value));
+		}
+	};
+
+	auto channel_name = [](auto const& name, unsigned int channel) {
+		return (channel > 1) ? psl::string(name) + psl::from_string8_t(utility::to_string((channel))) : psl::string(name);
+	};
+
+	add_vectors(psl::string(geometry_t::constants::POSITION), attribute_t::position, pAIMesh->mVertices);
+	if(pAIMesh->HasNormals())
+		add_vectors(psl::string(geometry_t::constants::NORMAL), attribute_t::direction, pAIMesh->mNormals);
+	if(pAIMesh->HasTangentsAndBitangents()) {
+		add_vectors(psl::string(geometry_t::constants::TANGENT), attribute_t::direction, pAIMesh->mTangents);
+		add_vectors(psl::string(geometry_t::constants::BITANGENT), attribute_t::direction, pAIMesh->mBitangents);
+	}
+
+	for(uint32_t uvChannel = 0; uvChannel < pAIMesh->GetNumUVChannels(); ++uvChannel) {
+		if(pAIMesh->HasTextureCoords(uvChannel)) {
+			auto& stream = result.emplace_back(
+			  attribute_stream_t {channel_name(geometry_t::constants::TEX, uvChannel), attribute_t::uv, 2, {}});
+			stream.values.reserve(order.size() * 2);
+			for(auto index : order) {
+				auto const& uv = pAIMesh->mTextureCoords[uvChannel][index];
+				stream.values.insert(std::end(stream.values), {uv.x, uv.y});
+			}
 		}
+	}
+
+	for(unsigned int c = 0; c < pAIMesh->GetNumColorChannels(); ++c) {
+		if(pAIMesh->HasVertexColors(c)) {
+			auto& stream = result.emplace_back(
+			  attribute_stream_t {channel_name(geometry_t::constants::COLOR, c), attribute_t::color, 4, {}});
+			stream.values.reserve(order.size() * 4);
+			for(auto index : order) {
+				auto const& color = pAIMesh->mColors[c][index];
+				stream.values.insert(std::end(stream.values), {color.r, color.g, color.b, color.a});
+			}
+		}
+	}
+	return result;
+}
+
+core::vertex_stream_t to_vertex_stream(attribute_stream_t const& stream) {
+	auto const& values		= stream.values;
+	auto const vertex_count = values.size() / stream.components;
+	switch(stream.components) {
+	case 2: {
+		core::vertex_stream_t result {core::vertex_stream_t::type::vec2};
+		auto& data = result.get<core::vertex_stream_t::type::vec2>();
+		data.resize(vertex_count);
+		for(size_t i = 0; i < vertex_count; ++i) data[i] = psl::vec2(values[i * 2], values[i * 2 + 1]);
+		return result;
+	}
+	case 3: {
+		core::vertex_stream_t result {core::vertex_stream_t::type::vec3};
+		auto& data = result.get<core::vertex_stream_t::type::vec3>();
+		data.resize(vertex_count);
+		for(size_t i = 0; i < vertex_count; ++i)
+			data[i] = psl::vec3(values[i * 3], values[i * 3 + 1], values[i * 3 + 2]);
+		return result;
+	}
+	default: {
+		core::vertex_stream_t result {core::vertex_stream_t::type::vec4};
+		auto& data = result.get<core::vertex_stream_t::type::vec4>();
+		data.resize(vertex_count);
+		for(size_t i = 0; i < vertex_count; ++i)
+			data[i] = psl::vec4(values[i * 4], values[i * 4 + 1], values[i * 4 + 2], values[i * 4 + 3]);
+		return result;
+	}
+	}
+}
+
+tools::geometry_stream_t quantize(attribute_stream_t const& stream) {
+	switch(stream.attribute) {
+	case attribute_t::position:
+		return tools::quantize_position(stream.name, stream.values);
+	case attribute_t::direction:
+		return tools::quantize_direction(stream.name, stream.values);
+	case attribute_t::uv:
+		return tools::quantize_uv(stream.name, stream.values);
+	case attribute_t::color:
+		return tools::quantize_color(stream.name, stream.values);
+	}
+	return tools::encode_float(stream.name, stream.values, stream.components);
+}
+
+// writes the meshlets of the geometry next to it
+bool write_meshlets(indices_t const& indices,
+					std::span<float const> positions,
+					psl::string const& output_file,
+					models::settings_t const& settings,
+					psl::array<psl::string>& written) {
+	auto const result =
+	  tools::build_meshlets(indices, positions, settings.meshlet_vertices, settings.meshlet_triangles);
+
+	details::meshlets_data_t data {};
+	data.vertices.value	 = result.vertices;
+	data.triangles.value = result.triangles;
+	for(auto const& meshlet : result.meshlets) {
+		data.meshlets.value.insert(
+		  std::end(data.meshlets.value),
+		  {meshlet.vertex_offset, meshlet.vertex_count, meshlet.triangle_offset, meshlet.triangle_count});
+		data.bounds.value.insert(std::end(data.bounds.value), std::begin(meshlet.center), std::end(meshlet.center));
+		data.bounds.value.emplace_back(meshlet.radius);
+		data.bounds.value.insert(
+		  std::end(data.bounds.value), std::begin(meshlet.cone_apex), std::end(meshlet.cone_apex));
+		data.bounds.value.insert(
+		  std::end(data.bounds.value), std::begin(meshlet.cone_axis), std::end(meshlet.cone_axis));
+		data.bounds.value.emplace_back(meshlet.cone_cutoff);
+	}
+	assembler::log->info("partitioned '{0}' into {1} meshlets", output_file, result.meshlets.size());
 
-		meta::file metaFile {uid};
-		cont = format::container {};
+	written.emplace_back(output_file + "." + psl::string(MESHLET_FORMAT));
+	written.emplace_back(written.back() + "." + psl::from_string8_t(meta::META_EXTENSION));
+	return write_meta(data, output_file, MESHLET_FORMAT, settings.binary);
+}
+
+// adds the bounds and bounding sphere of the positions to the meta, so the engine can cull the geometry without
+// having to compute them at runtime
+void add_bounds(meta_properties_t& properties, std::span<float const> positions) {
+	auto const bounds = tools::compute_bounding_volume(positions);
+	auto const vector = [](std::array<float, 3> const& value) {
+		return fmt::format("{},{},{}", value[0], value[1], value[2]);
+	};
+	properties.emplace_back("BOUNDS_MIN", vector(bounds.min));
+	properties.emplace_back("BOUNDS_MAX", vector(bounds.max));
+	properties.emplace_back("SPHERE_CENTER", vector(bounds.center));
+	properties.emplace_back("SPHERE_RADIUS", utility::to_string(bounds.radius));
+}
+
+// writes the geometry as a `core::data::geometry_t`, or as a `tools::geometry_file_t` when it is requested, or when
+// quantizing or interleaving. The paths of the written files are added to `written`.
+bool write_geometry(aiMesh* pAIMesh,
+					indices_t const& indices,
+					psl::array<uint32_t> const& order,
+					psl::string output_file,
+					models::settings_t const& settings,
+					meta_properties_t properties,
+					psl::array<psl::string>& written) {
+	auto const streams = gather_attributes(pAIMesh, order, settings.axis);
+	add_bounds(properties, streams.front().values);
+	if(settings.meshlets && pAIMesh->HasFaces() &&
+	   !write_meshlets(indices, streams.front().values, output_file, settings, written))
+		return false;
 
-		s.serialize<serialization::encode_to_format>(metaFile, cont);
-		if(!utility::platform::file::write(output_meta, cont.to_string())) {
+	if(settings.geometry_file()) {
+		tools::geometry_file_t file {};
+		file.indices.assign(std::begin(indices), std::end(indices));
+		file.layout	   = settings.layout;
+		file.alignment = settings.alignment;
+		for(auto const& stream : streams) {
+			file.streams.emplace_back(settings.quantize
+										? quantize(stream)
+										: tools::encode_float(stream.name, stream.values, stream.components));
+		}
+
+		output_file += "." + psl::string(GEOMETRY_FORMAT);
+		if(!assembler::write_if_changed(output_file, file.encode())) {
 			assembler::log->error("could not write the output file.");
 			return false;
 		}
+		written.emplace_back(output_file);
+		written.emplace_back(output_file + "." + psl::from_string8_t(meta::META_EXTENSION));
+		return write_meta_file(output_file, properties);
 	}
-	return true;
-}
 
-bool import_model(aiMesh* pAIMesh, psl::string output_file, std::array<uint8_t, 3> axis_setup, bool binary) {
 	geometry_t result;
-	typename std::decay<decltype(result.indices())>::type indices;
+	if(pAIMesh->HasFaces())
+		result.indices(indices);
+	for(auto const& stream : streams) result.vertices(stream.name, to_vertex_stream(stream));
+	written.emplace_back(output_file + "." + psl::string(MODEL_FORMAT));
+	written.emplace_back(written.back() + "." + psl::from_string8_t(meta::META_EXTENSION));
+	return write_meta(result, std::move(output_file), MODEL_FORMAT, settings.binary, properties);
+}
+
+// writes the geometry, split into parts whose indices fit in 16bit when that is requested and needed. The index size
+// the geometry needs is recorded in the meta. Only 'pgb' stores the indices in that size, 'pgf' always stores 32bit
+// indices, and the engine can narrow them on upload when the meta allows it.
+bool write_parts(aiMesh* pAIMesh,
+				 indices_t const& indices,
+				 psl::array<uint32_t> const& order,
+				 psl::string const& output_file,
+				 models::settings_t const& settings,
+				 meta_properties_t properties,
+				 psl::array<psl::string>& written) {
+	if(!settings.split || order.size() <= MAX_16BIT_VERTICES) {
+		properties.emplace_back("INDEX_SIZE", (order.size() <= MAX_16BIT_VERTICES) ? "2" : "4");
+		return write_geometry(pAIMesh, indices, order, output_file, settings, properties, written);
+	}
 
+	auto const parts = tools::split_by_vertex_count(indices, order.size(), MAX_16BIT_VERTICES);
+	assembler::log->info("split '{0}' into {1} parts, so they can use 16bit indices", output_file, parts.size() - 1);
+	properties.emplace_back("INDEX_SIZE", "2");
+	for(size_t part = 0; part + 1 < parts.size(); ++part) {
+		indices_t part_indices(std::next(std::begin(indices), parts[part]),
+							   std::next(std::begin(indices), parts[part + 1]));
+		auto const local = tools::optimize_vertex_fetch(part_indices, order.size());
+		psl::array<uint32_t> part_order(local.size());
+		for(size_t i = 0; i < local.size(); ++i) part_order[i] = order[local[i]];
+
+		auto part_properties = properties;
+		part_properties.emplace_back("PART", utility::to_string(part));
+		part_properties.emplace_back("PARTS", utility::to_string(parts.size() - 1));
+		if(!write_geometry(pAIMesh,
+						   part_indices,
+						   part_order,
+						   output_file + "_part" + std::to_string(part),
+						   settings,
+						   part_properties,
+						   written))
+			return false;
+	}
+	return true;
+}
+
+bool import_model(aiMesh* pAIMesh,
+				  psl::string output_file,
+				  models::settings_t const& settings,
+				  psl::array<psl::string>& written) {
+	auto const& axis_setup = settings.axis;
+	auto const& lods	   = settings.lods;
+	indices_t indices;
 
 	unsigned int nVertices {pAIMesh->mNumVertices};
 
@@ -148,97 +636,101 @@ bool import_model(aiMesh* pAIMesh, psl::string output_file, std::array<uint8_t,
 				indices[iface * 3 + j] = pAIFaces[iface].mIndices[j];
 			}
 		}
-
-		result.indices(indices);
 	}
-	core::vertex_stream_t vec4_stream {core::vertex_stream_t::type::vec4};
-	core::vertex_stream_t vec3_stream {core::vertex_stream_t::type::vec3};
-	core::vertex_stream_t vec2_stream {core::vertex_stream_t::type::vec2};
-	std::vector<psl::vec4>& datav4 = vec4_stream.get<core::vertex_stream_t::type::vec4>();
-	std::vector<psl::vec3>& datav3 = vec3_stream.get<core::vertex_stream_t::type::vec3>();
-	std::vector<psl::vec2>& datav2 = vec2_stream.get<core::vertex_stream_t::type::vec2>();
-	datav4.resize(nVertices);
-	datav3.resize(nVertices);
-	datav2.resize(nVertices);
-
-	if(pAIMesh->HasPositions()) {
-		for(unsigned int ivert = 0; ivert < nVertices; ivert++) {
-			datav3[ivert] = psl::vec3(pAIMesh->mVertices[ivert][axis_setup[0]],
-									  pAIMesh->mVertices[ivert][axis_setup[1]],
-									  pAIMesh->mVertices[ivert][axis_setup[2]]);
-		}
 
-		result.vertices(geometry_t::constants::POSITION, vec3_stream);
-	} else {
+	if(!pAIMesh->HasPositions()) {
 		assembler::log->error("the model has no position data.");
 		return false;
 	}
 
-	if(pAIMesh->HasNormals()) {
-		for(unsigned int i = 0; i < nVertices; i++) {
-			datav3[i] = normalize(psl::vec3(pAIMesh->mNormals[i][axis_setup[0]],
-											pAIMesh->mNormals[i][axis_setup[1]],
-											pAIMesh->mNormals[i][axis_setup[2]]));
-		}
-
-		result.vertices(geometry_t::constants::NORMAL, vec3_stream);
+	psl::array<psl::vec3> positions(nVertices);
+	for(unsigned int ivert = 0; ivert < nVertices; ivert++) {
+		positions[ivert] = psl::vec3(pAIMesh->mVertices[ivert][axis_setup[0]],
+									 pAIMesh->mVertices[ivert][axis_setup[1]],
+									 pAIMesh->mVertices[ivert][axis_setup[2]]);
 	}
 
-	if(pAIMesh->HasTangentsAndBitangents()) {
-		{
-			for(unsigned int i = 0; i < nVertices; i++) {
-				datav3[i] = normalize(psl::vec3(pAIMesh->mTangents[i][axis_setup[0]],
-												pAIMesh->mTangents[i][axis_setup[1]],
-												pAIMesh->mTangents[i][axis_setup[2]]));
-			}
+	// the LODs are simplified from the indices as assimp provided them
+	auto const source = (lods.empty()) ? indices_t {} : indices;
 
-			result.vertices(geometry_t::constants::TANGENT, vec3_stream);
-		}
-		{
-			for(unsigned int i = 0; i < nVertices; i++) {
-				datav3[i] = normalize(psl::vec3(pAIMesh->mBitangents[i][axis_setup[0]],
-												pAIMesh->mBitangents[i][axis_setup[1]],
-												pAIMesh->mBitangents[i][axis_setup[2]]));
-			}
+	psl::array<uint32_t> order(nVertices);
+	std::iota(std::begin(order), std::end(order), 0u);
+	if(pAIMesh->HasFaces() && settings.reorder)
+		order = optimize_geometry(pAIMesh, indices, positions, output_file, settings);
 
-			result.vertices(geometry_t::constants::BITANGENT, vec3_stream);
-		}
-	}
+	if(!write_parts(pAIMesh, indices, order, output_file, settings, {}, written))
+		return false;
 
-	for(uint32_t uvChannel = 0; uvChannel < pAIMesh->GetNumUVChannels(); ++uvChannel) {
-		if(pAIMesh->HasTextureCoords(uvChannel)) {
-			for(unsigned int i = 0; i < nVertices; i++) {
-				datav2[i] = psl::vec2(pAIMesh->mTextureCoords[uvChannel][i].x, pAIMesh->mTextureCoords[uvChannel][i].y);
-			}
+	if(lods.empty() || !pAIMesh->HasFaces())
+		return true;
 
-			if(uvChannel > 1)
-				result.vertices(psl::string(geometry_t::constants::TEX) +
-								  psl::from_string8_t(utility::to_string((uvChannel))),
-								vec2_stream);
-			else
-				result.vertices(geometry_t::constants::TEX, vec2_stream);
+	// normals and the first uv channel are taken into account, so the simplification avoids smearing them
+	size_t const attribute_count = (pAIMesh->HasNormals() ? 3 : 0) + (pAIMesh->HasTextureCoords(0) ? 2 : 0);
+	psl::array<float> attributes(nVertices * attribute_count);
+	for(unsigned int ivert = 0; ivert < nVertices; ivert++) {
+		auto attribute = std::next(std::begin(attributes), ivert * attribute_count);
+		if(pAIMesh->HasNormals()) {
+			for(size_t axis = 0; axis < 3; ++axis)
+				*attribute++ = pAIMesh->mNormals[ivert][axis_setup[axis]] * LOD_NORMAL_WEIGHT;
+		}
+		if(pAIMesh->HasTextureCoords(0)) {
+			*attribute++ = pAIMesh->mTextureCoords[0][ivert].x * LOD_UV_WEIGHT;
+			*attribute++ = pAIMesh->mTextureCoords[0][ivert].y * LOD_UV_WEIGHT;
 		}
 	}
 
-	for(unsigned int c = 0; c < pAIMesh->GetNumColorChannels(); ++c) {
-		if(pAIMesh->HasVertexColors(c)) {
-			for(unsigned int i = 0; i < nVertices; i++) {
-				datav4[i] = psl::vec4(pAIMesh->mColors[c][i].r,
-									  pAIMesh->mColors[c][i].g,
-									  pAIMesh->mColors[c][i].b,
-									  pAIMesh->mColors[c][i].a);
-			}
+	float extent {0.0f};
+	for(size_t axis = 0; axis < 3; ++axis) {
+		auto const [lowest, highest] = std::minmax_element(
+		  std::begin(positions), std::end(positions), [axis](auto const& lhs, auto const& rhs) {
+			  return lhs[axis] < rhs[axis];
+		  });
+		extent = std::max(extent, (*highest)[axis] - (*lowest)[axis]);
+	}
 
-			if(c > 1)
-				result.vertices(psl::string(geometry_t::constants::COLOR) +
-								  psl::from_string8_t(utility::to_string((c))),
-								vec4_stream);
-			else
-				result.vertices(geometry_t::constants::COLOR, vec4_stream);
+	auto previous = source.size();
+	for(size_t level = 1; level <= lods.size(); ++level) {
+		indices_t lod(source.size());
+		float error {0.0f};
+		lod.resize(tools::simplify(lod,
+								   source,
+								   positions,
+								   attributes,
+								   attribute_count,
+								   static_cast<size_t>(source.size() / 3 * lods[level - 1]) * 3,
+								   settings.lod_error,
+								   error));
+		if(lod.size() >= previous) {
+			assembler::log->info(
+			  "'{0}' can't be simplified further within the error limit, stopped the LOD chain at LOD {1}",
+			  output_file,
+			  level);
+			break;
 		}
-	}
+		previous = lod.size();
+
+		auto const lod_file	 = output_file + "_lod" + std::to_string(level);
+		auto const lod_order = settings.reorder
+								 ? optimize_geometry(pAIMesh, lod, positions, lod_file, settings)
+								 : tools::optimize_vertex_fetch(lod, nVertices);
+		assembler::log->info("generated LOD {0} of '{1}' with {2} of {3} triangles, and an error of {4:.5f}",
+							 level,
+							 output_file,
+							 lod.size() / 3,
+							 source.size() / 3,
+							 error);
 
-	return write_meta(result, std::move(output_file), MODEL_FORMAT, binary);
+		// the error is the largest root mean square distance (in model units) of a collapsed vertex to the original
+		// surface around it, see `tools::simplify`. It is an average and not a bound on how far the surface moved, the
+		// runtime turns it into a screen space error as `LOD_ERROR * projection scale / distance` to select the LOD.
+		// The relative error is the same value as a fraction of the largest dimension of the bounds.
+		meta_properties_t const properties {{"LOD", utility::to_string(level)},
+											{"LOD_ERROR", utility::to_string(error * extent)},
+											{"LOD_RELATIVE_ERROR", utility::to_string(error)}};
+		if(!write_parts(pAIMesh, lod, lod_order, lod_file, settings, properties, written))
+			return false;
+	}
+	return true;
 }
 
 template <typename T>
@@ -262,7 +754,9 @@ psl::mat4x4 convert(aiMatrix4x4t<T> const& source) {
 }
 
 bool import_skeleton(aiMesh* pAIMesh, psl::string output_file, bool binary) {
-	throw std::runtime_error("not implemented");
+	if(pAIMesh->mNumBones == 0)
+		return true;
+	assembler::log->error("'{0}' has bones, but importing skeletons is not implemented", output_file);
 	return false;
 
 	/*if(pAIMesh->mNumBones == 0) return true;
@@ -295,7 +789,8 @@ bool import_skeleton(aiMesh* pAIMesh, psl::string output_file, bool binary) {
 }
 
 bool import_animation(aiAnimation const& aiAnim, psl::string output_file, bool binary) {
-	throw std::runtime_error("not implemented");
+	assembler::log->error(
+	  "'{0}' has the animation '{1}', but importing animations is not implemented", output_file, aiAnim.mName.C_Str());
 	return false;
 	/*
 	core::data::animation anim;
@@ -359,39 +854,180 @@ void models::on_invoke(cli::pack& pack) {
 		}
 	}
 
-	auto input_file		  = pack["input"]->as<psl::string>().get();
-	auto output_file	  = pack["output"]->as<psl::string>().get();
-	bool encode_to_binary = pack["binary"]->as<bool>().get();
+	settings_t settings {};
+	settings.axis	   = axis_setup;
+	settings.axis_name = pack["axis"]->as<psl::string>().get();
+	settings.reorder   = pack["reorder"]->as<bool>().get();
+	settings.binary	   = pack["binary"]->as<bool>().get();
+	settings.lods	   = pack["lods"]->as<std::vector<float>>().get();
+	settings.lod_error = pack["lod error"]->as<float>().get();
+	settings.quantize  = pack["quantize"]->as<bool>().get();
+	settings.split	   = pack["split"]->as<bool>().get();
+	settings.mappable  = pack["mappable"]->as<bool>().get();
+
+	settings.alignment = pack["alignment"]->as<size_t>().get();
+
+	auto const interleave = pack["interleave"]->as<bool>().get();
+	auto const hybrid	  = pack["interleave hybrid"]->as<bool>().get();
+	if(interleave && hybrid) {
+		utility::terminal::set_color(utility::terminal::color::RED);
+		assembler::log->error("'--interleave' and '--interleave-hybrid' can't be combined, pick one of the layouts");
+		utility::terminal::set_color(utility::terminal::color::WHITE);
+		return;
+	}
+	if(hybrid)
+		settings.layout = tools::vertex_layout_t::hybrid;
+	else if(interleave)
+		settings.layout = tools::vertex_layout_t::interleaved;
+
+	settings.meshlets		   = pack["meshlets"]->as<bool>().get();
+	settings.meshlet_vertices  = pack["meshlet vertices"]->as<size_t>().get();
+	settings.meshlet_triangles = pack["meshlet triangles"]->as<size_t>().get();
+
+	auto ifile		   = assembler::pathstring {pack["input"]->as<psl::string>().get()};
+	auto ofile		   = assembler::pathstring {pack["output"]->as<psl::string>().get()};
+	auto jobs		   = pack["jobs"]->as<size_t>().get();
+	auto memory		   = pack["memory"]->as<size_t>().get();
+	m_ActionCache.directory(pack["cache"]->as<psl::string>().get());
+	auto const writes = assembler::write_statistics();
 
-	Assimp::Importer importer;
-	Assimp::DefaultLogger::create("", Assimp::Logger::VERBOSE);
+	assimp_logger_scope logger_scope {};
 
+	if(!proccess_flags(pack, settings.flags))
+		return;
 
-	unsigned int flags = 0u;
-	if(!proccess_flags(pack, flags))
+	if(settings.split && !settings.geometry_file()) {
+		utility::terminal::set_color(utility::terminal::color::RED);
+		assembler::log->error("'--split' needs the 'pgb' output ('--pgb', '--quantize' or '--interleave'), as 'pgf' "
+							  "always stores 32bit indices");
+		utility::terminal::set_color(utility::terminal::color::WHITE);
 		return;
+	}
 
-	if(!utility::platform::file::exists(input_file)) {
+	if(settings.meshlets && (settings.meshlet_vertices < 3 || settings.meshlet_vertices > 256 ||
+							 settings.meshlet_triangles == 0)) {
 		utility::terminal::set_color(utility::terminal::color::RED);
-		assembler::log->error("the file '{}' does not exist", input_file);
+		assembler::log->error("meshlets need between 3 and 256 vertices, and at least one triangle");
 		utility::terminal::set_color(utility::terminal::color::WHITE);
 		return;
 	}
 
-	if(input_file == output_file || output_file.empty()) {
-		output_file = input_file.substr(0, input_file.find_last_of(('.')));
+	if(settings.alignment == 0 || (settings.alignment & (settings.alignment - 1)) != 0) {
+		utility::terminal::set_color(utility::terminal::color::RED);
+		assembler::log->error("the alignment should be a power of two, but was {0}", settings.alignment);
+		utility::terminal::set_color(utility::terminal::color::WHITE);
+		return;
+	}
+
+	for(auto ratio : settings.lods) {
+		if(ratio <= 0.0f || ratio >= 1.0f) {
+			utility::terminal::set_color(utility::terminal::color::RED);
+			assembler::log->error("the LOD ratios should be between 0 and 1 (exclusive), you provided {}", ratio);
+			utility::terminal::set_color(utility::terminal::color::WHITE);
+			return;
+		}
+	}
+
+	auto const wildcard = !ifile->empty() && ifile[ifile->size() - 1] == '*';
+	auto files			= assembler::get_files(ifile, ofile);
+
+	// meshes of a single file get converted concurrently as well, share the workers with the files
+	settings.jobs = std::max<size_t>(
+	  1u, assembler::resolve_jobs(jobs) / std::max<size_t>(1u, std::min(assembler::resolve_jobs(jobs), files.size())));
+
+	scene_budget budget {memory * 1024u * 1024u};
+	std::atomic<size_t> success = 0;
+	std::atomic<size_t> skipped = 0;
+	assembler::parallel_for(files.size(), jobs, [&](size_t index) {
+		// assimp keeps its internal state in the importer, every worker keeps one around for all the files it imports
+		thread_local Assimp::Importer importer;
+
+		auto const& file		= files[index];
+		auto const input_file	= file.first.platform();
+		psl::string output_file	= file.second;
+		if(wildcard) {
+			auto const dot = input_file.find_last_of('.');
+			if(dot == psl::string::npos || !importer.IsExtensionSupported(input_file.substr(dot).c_str())) {
+				assembler::log->info("skipping {0}", input_file);
+				++skipped;
+				return;
+			}
+		}
+		if(wildcard || ofile->empty() || file.first.data() == file.second.data()) {
+			output_file = output_file.substr(0, output_file.find_last_of(('.')));
+		}
+		output_file = utility::platform::directory::to_unix(output_file);
+
+		if(!utility::platform::file::exists(input_file)) {
+			utility::terminal::set_color(utility::terminal::color::RED);
+			assembler::log->error("the file '{}' does not exist", input_file);
+			utility::terminal::set_color(utility::terminal::color::WHITE);
+			return;
+		}
+
+		std::error_code error {};
+		auto const size		= std::filesystem::file_size(input_file, error);
+		auto const estimate = error ? size_t {0} : static_cast<size_t>(size) * SCENE_MEMORY_FACTOR;
+		budget.acquire(estimate);
+		auto const result = import_file(importer, input_file, output_file, settings);
+		importer.FreeScene();
+		budget.release(estimate);
+		if(result)
+			++success;
+	});
+
+	if(wildcard)
+		assembler::log->info(
+		  "imported {0} of {1} files, skipped {2}", success.load(), files.size() - skipped.load(), skipped.load());
+	assembler::log_write_statistics(writes);
+}
+
+bool models::import_file(Assimp::Importer& importer,
+						 psl::string const& input_file,
+						 psl::string const& output_file,
+						 settings_t const& settings) const {
+	uint64_t cache_key {0};
+	if(m_ActionCache.enabled()) {
+		auto const lods = std::accumulate(
+		  std::begin(settings.lods), std::end(settings.lods), psl::string {}, [](psl::string result, float ratio) {
+			  return std::move(result) + utility::to_string(ratio) + " ";
+		  });
+		auto content = utility::platform::file::read(input_file);
+		if(!content) {
+			assembler::log->error("could not read '{}'", input_file);
+			return false;
+		}
+		cache_key = m_ActionCache.key("models",
+									  psl::to_string8_t(content.value()),
+									  fmt::format("{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}|{}",
+												  settings.flags,
+												  settings.axis_name,
+												  settings.reorder,
+												  lods,
+												  settings.lod_error,
+												  settings.quantize,
+												  settings.mappable,
+												  settings.split,
+												  std::to_underlying(settings.layout),
+												  settings.alignment,
+												  settings.meshlets,
+												  settings.meshlet_vertices,
+												  settings.meshlet_triangles,
+												  settings.binary));
+		if(m_ActionCache.restore(cache_key, output_file)) {
+			assembler::log->info("restored the models of '{0}' from the cache", input_file);
+			return true;
+		}
 	}
-	input_file	= utility::platform::directory::to_platform(input_file);
-	output_file = utility::platform::directory::to_unix(output_file);
 
-	aiScene const* pScene = importer.ReadFile(psl::to_string8_t(input_file), flags);
+	aiScene const* pScene = importer.ReadFile(psl::to_string8_t(input_file), settings.flags);
 	psl::string errorMessage;
 	if(!pScene) {
 		utility::terminal::set_color(utility::terminal::color::RED);
 		assembler::log->error("the scene of the file '{0}' could not be loaded by assimp", input_file);
 		assembler::log->error(importer.GetErrorString());
 		utility::terminal::set_color(utility::terminal::color::WHITE);
-		return;
+		return false;
 	}
 
 	std::unordered_map<size_t, psl::string> meshNames;
@@ -412,32 +1048,48 @@ void models::on_invoke(cli::pack& pack) {
 
 	recurse_log(0, root, meshNames);
 
+	// names are resolved up front, so they don't depend on the order in which the meshes get processed. Meshes that
+	// share a node name get their index appended, so concurrently processed meshes never write to the same file.
+	psl::array<psl::string> appendages(pScene->mNumMeshes);
+	std::unordered_set<psl::string> used_appendages {};
 	for(unsigned int m = 0; m < pScene->mNumMeshes; ++m) {
-		auto output_appendage = (pScene->mNumMeshes > 1) ? "_" + std::to_string(m) : "";
-		if(!output_appendage.empty() && m < 10)
-			output_appendage.insert(1, "0");
-
-		output_appendage = (pScene->mNumMeshes > 1) ? "_" + meshNames[m] : "";
-		if(!import_model(pScene->mMeshes[m], output_file + output_appendage, axis_setup, encode_to_binary) ||
-		   !import_skeleton(pScene->mMeshes[m], output_file + output_appendage, encode_to_binary))
-			goto error;
+		appendages[m] = (pScene->mNumMeshes > 1) ? "_" + meshNames[m] : "";
+		if(!used_appendages.emplace(appendages[m]).second) {
+			appendages[m] += "_" + std::to_string(m);
+			used_appendages.emplace(appendages[m]);
+		}
 	}
 
+	// once assimp loaded the scene the meshes are independent, so they get converted and written concurrently
+	std::atomic<bool> failed {false};
+	psl::array<psl::array<psl::string>> written(pScene->mNumMeshes);
+	assembler::parallel_for(pScene->mNumMeshes, settings.jobs, [&](size_t m) {
+		if(!import_model(pScene->mMeshes[m], output_file + appendages[m], settings, written[m]) ||
+		   !import_skeleton(pScene->mMeshes[m], output_file + appendages[m], settings.binary))
+			failed = true;
+	});
+	if(failed)
+		goto error;
+
 
 	for(auto i = 0u; i < pScene->mNumAnimations; ++i) {
 		auto& animation = *pScene->mAnimations[i];
-		if(!import_animation(animation, output_file, encode_to_binary))
+		if(!import_animation(animation, output_file, settings.binary))
 			goto error;
 	}
 
-	importer.FreeScene();
-	Assimp::DefaultLogger::kill();
-	return;
+	if(m_ActionCache.enabled()) {
+		// the amount of LODs and parts depends on the mesh, so the outputs are whatever got written
+		psl::array<psl::string> outputs {};
+		for(auto const& files : written) {
+			for(auto const& file : files) outputs.emplace_back(file.substr(output_file.size()));
+		}
+		m_ActionCache.store(cache_key, output_file, outputs);
+	}
+	return true;
 error:
-	importer.FreeScene();
 	utility::terminal::set_color(utility::terminal::color::RED);
 	assembler::log->error(errorMessage);
 	utility::terminal::set_color(utility::terminal::color::WHITE);
-	Assimp::DefaultLogger::kill();
-	return;
+	return false;
 }
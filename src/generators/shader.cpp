@@ -1,5 +1,8 @@
 ﻿#include "generators/shader.h"
 #include "core/gfx/types.hpp"
+#include "details/hash.hpp"
+#include "details/output.hpp"
+#include "details/parallel.hpp"
 #include "details/spirv.hpp"
 #include "psl/application_utils.hpp"
 #include "psl/library.hpp"
@@ -11,20 +14,70 @@
 #include "utils.h"
 #include <filesystem>
 #include <iostream>
+#include <numeric>
 
-#if defined(AS_ENABLE_WGSL)
-	#include "tint/tint.h"
-#endif
 // todo we should figure out the bindings dynamically instead of having them written into the files, and then
 // potentially safeguard the user from accidentally merging shaders together that do not work together
 
 using namespace assembler::generators;
 using namespace psl;
 
+namespace details {
+struct dependency_entry_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << path << last_modified << hash << options << dependents;
+	}
+
+	static constexpr char const serialization_name[6] {"ENTRY"};
+	psl::serialization::property<"PATH", psl::string> path;
+	psl::serialization::property<"TIME", uint64_t> last_modified;
+	psl::serialization::property<"HASH", uint64_t> hash;
+	psl::serialization::property<"OPTIONS", psl::string> options;
+	psl::serialization::property<"DEPENDENTS", psl::array<psl::string>> dependents;
+};
+
+struct variant_entry_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << name << defines << output;
+	}
+
+	static constexpr char const serialization_name[8] {"VARIANT"};
+	psl::serialization::property<"NAME", psl::string> name;
+	psl::serialization::property<"DEFINES", psl::array<psl::string>> defines;
+	// name of the variant whose output this variant uses, the output is `<table without extension>-<OUTPUT>`
+	psl::serialization::property<"OUTPUT", psl::string> output;
+};
+
+struct variant_table_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << variants;
+	}
+
+	static constexpr char const serialization_name[9] {"VARIANTS"};
+	psl::serialization::property<"VARIANTS", psl::array<variant_entry_t>> variants;
+};
+
+struct dependency_graph_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << entries;
+	}
+
+	static constexpr char const serialization_name[6] {"GRAPH"};
+	psl::serialization::property<"ENTRIES", psl::array<dependency_entry_t>> entries;
+};
+}	 // namespace details
 
 bool shader::parse(file_data& data) {
 	auto inc_n = data.content.find(("#include"));
-	while(inc_n != psl::string_view::npos) {
+	while(inc_n != psl::string::npos) {
 		auto endline_n	  = data.content.find(("\n"), inc_n);
 		auto file_begin_n = data.content.find(("\""), inc_n);
 		if(file_begin_n > endline_n)
@@ -82,25 +135,50 @@ bool shader::parse(file_data& data) {
 		if(!cache_file(include_path))
 			return false;
 
-		data.includes.emplace_back(std::make_pair(include_path, inc_n));
-		data.content.erase(std::begin(data.content) + inc_n, std::begin(data.content) + endline_n);
+		// the directive stays in the content, it gets skipped over when the shader is expanded
+		auto const directive_end = (endline_n == psl::string::npos) ? data.content.size() : endline_n;
+		data.includes.emplace_back(include_t {include_path, inc_n, directive_end - inc_n});
 
-		inc_n = data.content.find(("#include"), inc_n);
+		inc_n = data.content.find(("#include"), directive_end);
 	}
 
 	return true;
 }
 
+size_t shader::include_tree_size(psl::string const& file) const {
+	std::set<psl::string_view> visited {};
+	psl::array<psl::string_view> pending {file};
+	while(!pending.empty()) {
+		auto const current = pending.back();
+		pending.pop_back();
+		if(!visited.insert(current).second)
+			continue;
+		if(auto it = m_Cache.find(psl::string {current}); it != std::end(m_Cache)) {
+			for(auto const& include : it->second.includes) pending.emplace_back(include.path);
+		}
+	}
+	return visited.size();
+}
+
 bool shader::cache_file(psl::string const& file) {
+	std::lock_guard lock {m_CacheMutex};
 	auto it = m_Cache.find(file);
-	if(it != m_Cache.end() &&
-	   std::filesystem::last_write_time(file).time_since_epoch().count() == it->second.last_modified) {
+	if(it != m_Cache.end() && it->second.validated == m_Epoch) {
+		// already validated (together with its dependencies) during this invocation of on_generate, common headers
+		// reached through many include paths are only ever checked once.
+		++m_ValidationStats.skipped;
+		m_ValidationStats.stats += include_tree_size(file);
+		return true;
+	}
+	auto const last_modified = std::filesystem::last_write_time(file).time_since_epoch().count();
+	if(it != m_Cache.end() && last_modified == it->second.last_modified) {
 		if(m_Verbose) {
 			assembler::log->info("{0} was found in the cache", file);
 			assembler::log->info("\tchecking its dependencies..\n");
 		}
+		it->second.validated = m_Epoch;
 		for(auto const& include : it->second.includes) {
-			cache_file(include.first);
+			cache_file(include.path);
 		}
 		return true;
 	} else {
@@ -114,44 +192,70 @@ bool shader::cache_file(psl::string const& file) {
 			assembler::log->error("ERROR: the encoding was not valid UTF-8 for the file: " + file);
 			utility::terminal::set_color(utility::terminal::color::WHITE);
 			return false;
+		} else if(it != m_Cache.end() && m_Hash && assembler::hash64(res.value()) == it->second.hash) {
+			// only the write time changed (checkout, rsync, ...), the parsed data can be kept as is
+			if(m_Verbose)
+				assembler::log->info("{0} has a new write time, but its content is unchanged", file);
+			++m_ValidationStats.rehashed;
+			it->second.last_modified = last_modified;
+			it->second.validated	 = m_Epoch;
+			for(auto const& include : it->second.includes) {
+				cache_file(include.path);
+			}
 		} else {
 			if(m_Verbose)
 				assembler::log->info(file + " is being loaded into the cache\n");
 			file_data fdata;
 			fdata.content		= std::move(res.value());
-			fdata.last_modified = std::filesystem::last_write_time(file).time_since_epoch().count();
+			fdata.last_modified = last_modified;
+			fdata.hash			= m_Hash ? assembler::hash64(fdata.content) : 0;
 			fdata.filename		= file;
-			auto& data = m_Cache[file] = fdata;
+			fdata.validated		= m_Epoch;
+			auto& data = m_Cache[file] = std::move(fdata);
 			parse(data);
 		}
 	}
 	return true;
 }
 
-psl::string shader::construct(file_data const& fdata, std::set<psl::string_view>& includes) const {
-	psl::string res = fdata.content;
-
+void shader::segments(file_data const& fdata,
+					  std::set<psl::string_view>& includes,
+					  psl::array<psl::string_view>& result) const {
+	psl::string_view content {fdata.content};
 	size_t offset = 0u;
 	for(auto const& inc : fdata.includes) {
-		if(includes.find(inc.first) == std::end(includes)) {
-			includes.insert(inc.first);
-			auto it = m_Cache.find(inc.first);
+		result.emplace_back(content.substr(offset, inc.offset - offset));
+		offset = inc.offset + inc.length;
+		if(includes.find(inc.path) == std::end(includes)) {
+			includes.insert(inc.path);
+			auto it = m_Cache.find(inc.path);
 			if(it == std::end(m_Cache)) {
-				assembler::log->error("the include" + inc.first + " is not present in the cache.");
+				assembler::log->error("the include" + inc.path + " is not present in the cache.");
 				continue;
 			}
-			auto sub_res {construct(it->second, includes)};
-			res.insert(inc.second + offset, sub_res);
-			offset += sub_res.size();
+			segments(it->second, includes, result);
 		}
 	}
-	return res;
+	result.emplace_back(content.substr(offset));
+}
+
+psl::string shader::expand(file_data const& fdata) const {
+	// gather views into the cached files first, so that the final source can be built with a single allocation
+	std::set<psl::string_view> includes;
+	psl::array<psl::string_view> views;
+	segments(fdata, includes, views);
+
+	psl::string result;
+	result.reserve(std::accumulate(
+	  std::begin(views), std::end(views), size_t {0}, [](size_t size, auto const& view) { return size + view.size(); }));
+	for(auto const& view : views) result.append(view);
+	return result;
 }
 
 bool shader::generate(assembler::pathstring ifile,
 					  assembler::pathstring ofile,
 					  bool compiled_glsl,
-					  bool optimize,
+					  tools::optimization_t optimize,
 					  psl::array<psl::string> types) {
 	auto directory = utility::platform::file::to_platform(ofile->substr(0, ofile->find_last_of("/")));
 	if(!utility::platform::directory::exists(directory))
@@ -181,34 +285,21 @@ bool shader::generate(assembler::pathstring ifile,
 
 	psl::timer timer;
 
-	try {
-		if(!cache_file(ifile.platform())) {
-			assembler::log->error(
-			  "something went wrong when loading the file in the cache, please consult the output to see why");
-			return false;
-		}
-	} catch(std::exception e) {
-		assembler::log->error("exception happened during caching! \n" + psl::string8_t(e.what()));
-	}
-
-	auto const& data = m_Cache[ifile.platform()];
-
-	// emplace include data
-	psl::string content = data.content;
-	std::set<psl::string_view> includes;
-	size_t offset = 0u;
-	for(auto const& inc : data.includes) {
-		if(includes.find(inc.first) == std::end(includes)) {
-			includes.insert(inc.first);
-			auto it = m_Cache.find(inc.first);
-			if(it == std::end(m_Cache)) {
-				assembler::log->error("the include" + inc.first + " is not present in the cache.");
-				continue;
+	// the cache is shared between all concurrently generated shaders, so only the compilation itself runs unguarded
+	psl::string content;
+	{
+		std::lock_guard lock {m_CacheMutex};
+		try {
+			if(!cache_file(ifile.platform())) {
+				assembler::log->error(
+				  "something went wrong when loading the file in the cache, please consult the output to see why");
+				return false;
 			}
-			auto sub_res {construct(it->second, includes)};
-			content.insert(std::begin(content) + inc.second + offset, std::begin(sub_res), std::end(sub_res));
-			offset += sub_res.size();
+		} catch(std::exception e) {
+			assembler::log->error("exception happened during caching! \n" + psl::string8_t(e.what()));
 		}
+
+		content = expand(m_Cache[ifile.platform()]);
 	}
 
 	std::optional<size_t> gles_version;
@@ -216,80 +307,370 @@ bool shader::generate(assembler::pathstring ifile,
 		gles_version = (type == tools::shader_stage_t::comp) ? 310 : 300;
 	}
 
-	if(auto result = tools::glsl_compile(content, (tools::shader_stage_t)type, optimize, gles_version); !result) {
-		assembler::log->error("errors while generating:");
-		for(auto const& message : result.messages) {
-			if(message.error) {
-				assembler::log->error(message.message);
-			} else {
-				assembler::log->info(message.message);
-			}
-		}
+	auto const output_file = ofile.platform();
+	auto const cache_key   = m_ActionCache.key("shader",
+											   content,
+											   fmt::format("{}|{}|{}|{}",
+														   std::to_underlying(type),
+														   std::to_underlying(optimize),
+														   gles_version.value_or(0),
+														   m_VariantsHash));
+	if(m_ActionCache.restore(cache_key, output_file)) {
+		assembler::log->info("restored {0} from the cache", output_file);
+		return true;
+	}
 
-		return false;
+	bool success = false;
+	if(m_Variants.empty()) {
+		auto result = tools::glsl_compile(content, (tools::shader_stage_t)type, optimize, gles_version);
+		if(!result)
+			assembler::log->error("errors while generating:");
+		log_messages(result);
+		success = result && write(result, output_file);
 	} else {
-		for(auto const& message : result.messages) {
-			if(message.error) {
-				assembler::log->error(message.message);
-			} else {
-				assembler::log->info(message.message);
-			}
+		success = generate_variants(content, (tools::shader_stage_t)type, optimize, gles_version, output_file);
+	}
+
+	if(success && m_ActionCache.enabled()) {
+		constexpr psl::string_view extensions[] {".spv", ".gles", ".wgsl"};
+		psl::array<psl::string> outputs {};
+		auto add_outputs = [&outputs](psl::string const& prefix) {
+			for(auto extension : extensions) outputs.emplace_back(prefix + psl::string(extension));
+			outputs.emplace_back(prefix + "." + psl::meta::META_EXTENSION);
+		};
+		if(m_Variants.empty()) {
+			add_outputs("");
+		} else {
+			for(auto const& variant : m_Variants) add_outputs("-" + variant.name);
+			outputs.emplace_back(".variants");
 		}
+		m_ActionCache.store(cache_key, output_file, outputs);
+	}
+	return success;
+}
 
-		auto output_file = ofile.platform();
-		if(!result.spirv.empty() && !utility::platform::file::write(output_file + ".spv", result.spirv)) {
-			assembler::log->error("failed to write the spirv to: {}", output_file + ".spv");
+void shader::log_messages(tools::glsl_compile_result_t const& result) const {
+	for(auto const& message : result.messages) {
+		if(message.error) {
+			assembler::log->error(message.message);
+		} else {
+			assembler::log->info(message.message);
 		}
-		if(!result.gles.empty() && !utility::platform::file::write(output_file + ".gles", result.gles)) {
-			assembler::log->error("failed to write the gles to: {}", output_file + ".gles");
+	}
+	if(result && result.unoptimized.bytes > 0) {
+		assembler::log->info("optimized from {0} to {1} instructions, and from {2} to {3} bytes",
+							 result.unoptimized.instructions,
+							 result.optimized.instructions,
+							 result.unoptimized.bytes,
+							 result.optimized.bytes);
+	}
+}
+
+bool shader::write(tools::glsl_compile_result_t const& result, psl::string const& output_file) {
+	if(!result.spirv.empty() && !assembler::write_if_changed(output_file + ".spv", result.spirv.bytes())) {
+		assembler::log->error("failed to write the spirv to: {}", output_file + ".spv");
+	}
+	if(!result.gles.empty() && !assembler::write_if_changed(output_file + ".gles", result.gles)) {
+		assembler::log->error("failed to write the gles to: {}", output_file + ".gles");
+	}
+	if(!result.wgsl.empty() && !assembler::write_if_changed(output_file + ".wgsl", result.wgsl)) {
+		assembler::log->error("failed to write the wgsl to: {}", output_file + ".wgsl");
+	}
+	if(result.shader.stage != core::gfx::shader_stage {0}) {
+		auto output_meta_file = output_file + "." + psl::meta::META_EXTENSION;
+		psl::UID uid		  = psl::UID::generate();
+		if(utility::platform::file::exists(output_meta_file)) {
+			meta::file* original = nullptr;
+			serialization::serializer temp_s;
+			if(temp_s.deserialize<serialization::decode_from_format>(original, output_meta_file) && original)
+				uid = original->ID();
+			delete(original);
 		}
-#if defined(AS_ENABLE_WGSL)
-		if(!result.spirv.empty()) {
-			auto spirv = std::vector<uint32_t>(result.spirv.size() / sizeof(uint32_t));
-			std::memcpy(spirv.data(), result.spirv.data(), result.spirv.size());
-			auto spirvReadOption = tint::spirv::reader::Options {};
-			auto tintIr		 = tint::spirv::reader::Read(spirv, spirvReadOption);
-			if (tintIr.Diagnostics().contains_errors()) {
-				assembler::log->error("failed to convert the spirv to tint-ir: {}", tintIr.Diagnostics().str());
-				return false;
-			}
-			auto wgslOptions = tint::wgsl::writer::Options();
-			auto tintWgslRes = tint::wgsl::writer::Generate(tintIr, wgslOptions);
-			if(tintWgslRes != tint::Success) {
-				assembler::log->error("failed to convert the tint-ir to wgsl: {}", tintWgslRes.Failure().reason.str());
-				return false;
-			}
-			auto wgsl = tintWgslRes.Move();
-			if(!utility::platform::file::write(output_file + ".wgsl", wgsl.wgsl)) {
-				assembler::log->error("failed to write the wgsl to: {}", output_file + ".wgsl");
-			}
+		core::meta::shader shaderMeta {uid};
+		shaderMeta.inputs(result.shader.inputs);
+		shaderMeta.outputs(result.shader.outputs);
+		shaderMeta.descriptors(result.shader.descriptors);
+		shaderMeta.stage(result.shader.stage);
+		serialization::serializer s;
+		format::container container;
+		s.serialize<serialization::encode_to_format>(&shaderMeta, container);
+		if(!assembler::write_if_changed(output_meta_file, container.to_string()))
+			assembler::log->error("failed to write the meta to: {}", output_meta_file);
+	}
+	return true;
+}
+
+bool shader::generate_variants(psl::string_view content,
+							   tools::shader_stage_t type,
+							   tools::optimization_t optimize,
+							   std::optional<size_t> gles_version,
+							   psl::string const& output_file) {
+	// all variants share the expanded source, their defines are injected right after the #version directive
+	size_t insert_at {0};
+	if(auto const version = content.find("#version"); version != psl::string_view::npos) {
+		auto const end_of_line = content.find('\n', version);
+		insert_at			   = (end_of_line == psl::string_view::npos) ? content.size() : end_of_line + 1;
+	}
+
+	psl::array<tools::glsl_compile_result_t> results(m_Variants.size());
+	assembler::parallel_for(m_Variants.size(), m_VariantJobs, [&](size_t index) {
+		auto const& variant = m_Variants[index];
+		psl::string source;
+		source.reserve(content.size() + variant.defines.size() * 32);
+		source.append(content.substr(0, insert_at));
+		for(auto const& define : variant.defines) {
+			auto const split = define.find('=');
+			source += "#define " +
+					  ((split == psl::string::npos) ? define : define.substr(0, split) + " " + define.substr(split + 1)) +
+					  "\n";
+		}
+		source.append(content.substr(insert_at));
+
+		results[index] = tools::glsl_compile(source, type, optimize, gles_version);
+		if(!results[index])
+			assembler::log->error("errors while generating the variant '{}':", variant.name);
+		log_messages(results[index]);
+	});
+
+	// variants that compiled into identical spirv collapse into a single output, owned by the first such variant
+	psl::array<size_t> owners {};
+	psl::array<size_t> variant_to_blob(m_Variants.size());
+	std::unordered_multimap<uint64_t, size_t> blobs {};
+	for(size_t i = 0; i < results.size(); ++i) {
+		if(!results[i])
+			return false;
+		auto const hash			= assembler::hash64(results[i].spirv.data(), results[i].spirv.bytes().size());
+		auto const [begin, end] = blobs.equal_range(hash);
+		auto const it			= std::find_if(begin, end, [&](auto const& blob) {
+			return results[owners[blob.second]].spirv == results[i].spirv;
+		});
+		if(it != end) {
+			variant_to_blob[i] = it->second;
 		} else {
-			assembler::log->error("no spirv was generated, so no wgsl can be generated");
+			variant_to_blob[i] = owners.size();
+			blobs.emplace(hash, owners.size());
+			owners.emplace_back(i);
 		}
+	}
+
+	// only the variant is stored, so the table stays valid when it is restored under another name or location
+	details::variant_table_t table;
+	for(size_t i = 0; i < m_Variants.size(); ++i) {
+		auto& entry			= table.variants.value.emplace_back();
+		entry.name.value	= m_Variants[i].name;
+		entry.defines.value = m_Variants[i].defines;
+		entry.output.value	= m_Variants[owners[variant_to_blob[i]]].name;
+	}
+
+	bool success = true;
+	for(auto owner : owners) {
+		success &= write(results[owner], output_file + "-" + m_Variants[owner].name);
+	}
+
+	serialization::serializer s;
+	format::container container;
+	s.serialize<serialization::encode_to_format>(table, container);
+	if(!assembler::write_if_changed(output_file + ".variants", container.to_string())) {
+		assembler::log->error("failed to write the variant mapping to: {}", output_file + ".variants");
+		return false;
+	}
+	assembler::log->info("{0} variants resulted in {1} unique outputs", m_Variants.size(), owners.size());
+	return success;
+}
+
+bool shader::outputs_exist(psl::string const& output_file, bool gles) const {
+	auto exists = [gles](psl::string const& prefix) {
+		psl::array<psl::string> outputs {prefix + ".spv", prefix + "." + psl::meta::META_EXTENSION};
+		if(gles)
+			outputs.emplace_back(prefix + ".gles");
+#if defined(AS_ENABLE_WGSL)
+		outputs.emplace_back(prefix + ".wgsl");
 #endif
-		if(result.shader.stage != core::gfx::shader_stage {0}) {
-			auto output_meta_file = output_file + "." + psl::meta::META_EXTENSION;
-			psl::UID uid		  = psl::UID::generate();
-			if(utility::platform::file::exists(output_meta_file)) {
-				meta::file* original = nullptr;
-				serialization::serializer temp_s;
-				temp_s.deserialize<serialization::decode_from_format>(original, output_file);
-				uid = original->ID();
-			}
-			core::meta::shader shaderMeta {uid};
-			shaderMeta.inputs(result.shader.inputs);
-			shaderMeta.outputs(result.shader.outputs);
-			shaderMeta.descriptors(result.shader.descriptors);
-			shaderMeta.stage(result.shader.stage);
-			serialization::serializer s;
-			format::container container;
-			s.serialize<serialization::encode_to_format>(&shaderMeta, container);
-			utility::platform::file::write(output_meta_file, psl::from_string8_t(container.to_string()));
+		return std::all_of(std::begin(outputs), std::end(outputs), [](psl::string const& output) {
+			return utility::platform::file::exists(output);
+		});
+	};
+	if(m_Variants.empty())
+		return exists(output_file);
+
+	auto const table_file = output_file + ".variants";
+	if(!utility::platform::file::exists(table_file))
+		return false;
+	details::variant_table_t table;
+	serialization::serializer s;
+	if(!s.deserialize<serialization::decode_from_format>(table, table_file) ||
+	   table.variants.value.size() != m_Variants.size())
+		return false;
+	return std::all_of(std::begin(table.variants.value), std::end(table.variants.value), [&](auto const& entry) {
+		return exists(output_file + "-" + entry.output.value);
+	});
+}
+
+bool shader::load_variants(psl::string const& file) {
+	m_Variants.clear();
+	m_VariantsHash = 0;
+	if(file.empty())
+		return true;
+
+	auto content = utility::platform::file::read(file);
+	if(!content) {
+		utility::terminal::set_color(utility::terminal::color::RED);
+		assembler::log->error("ERROR: no variant manifest was found at the location: " + file);
+		utility::terminal::set_color(utility::terminal::color::WHITE);
+		return false;
+	}
+	m_VariantsHash = assembler::hash64(content.value());
+
+	// every non-empty line that isn't a comment is a variant, written as `name: DEFINE DEFINE=VALUE ...`
+	size_t line_number = 0;
+	for(auto line : utility::string::split(content.value(), "\n")) {
+		++line_number;
+		line = trim(line);
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		auto const split = line.find(':');
+		if(split == psl::string_view::npos || trim(line.substr(0, split)).empty()) {
+			utility::terminal::set_color(utility::terminal::color::RED);
+			assembler::log->error("ERROR: the variant at line '{}' of '{}' has no name, expected 'name: DEFINES'",
+								  line_number,
+								  file);
+			utility::terminal::set_color(utility::terminal::color::WHITE);
+			return false;
+		}
+
+		auto const name = trim(line.substr(0, split));
+		if(std::any_of(std::begin(m_Variants), std::end(m_Variants), [name](auto const& other) {
+			   return other.name == name;
+		   })) {
+			utility::terminal::set_color(utility::terminal::color::RED);
+			assembler::log->error(
+			  "ERROR: the variant name '{}' at line '{}' of '{}' is used more than once", name, line_number, file);
+			utility::terminal::set_color(utility::terminal::color::WHITE);
+			return false;
+		}
+
+		auto& variant = m_Variants.emplace_back();
+		variant.name  = name;
+		for(auto const& define : utility::string::split(line.substr(split + 1), " ")) {
+			if(!trim(define).empty())
+				variant.defines.emplace_back(trim(define));
 		}
 	}
 	return true;
 }
 
+std::unordered_map<psl::string, shader::dependency_node_t> shader::read_dependencies(psl::string const& file) {
+	std::unordered_map<psl::string, dependency_node_t> result {};
+	if(!utility::platform::file::exists(file))
+		return result;
+
+	details::dependency_graph_t graph;
+	serialization::serializer s;
+	s.deserialize<serialization::decode_from_format>(graph, file);
+	for(auto const& entry : graph.entries.value) {
+		auto& node		   = result[entry.path.value];
+		node.last_modified = entry.last_modified.value;
+		node.hash		   = entry.hash.value;
+		node.options	   = entry.options.value;
+		node.dependents.insert(std::begin(entry.dependents.value), std::end(entry.dependents.value));
+	}
+	return result;
+}
+
+void shader::load_dependencies(psl::string const& file) {
+	m_Dependencies = read_dependencies(file);
+}
+
+void shader::save_dependencies(psl::string const& file) const {
+	// concurrent batch jobs can share the file, so whatever the others saved in the meantime is merged with our graph
+	static std::mutex mutex;
+	std::lock_guard lock {mutex};
+	auto merged = read_dependencies(file);
+	for(auto const& [path, node] : m_Dependencies) {
+		auto& target	= merged[path];
+		auto dependents = std::move(target.dependents);
+		target			= node;
+		target.dependents.insert(std::begin(dependents), std::end(dependents));
+	}
+
+	details::dependency_graph_t graph;
+	graph.entries.value.reserve(merged.size());
+	for(auto const& [path, node] : merged) {
+		auto& entry				  = graph.entries.value.emplace_back();
+		entry.path.value		  = path;
+		entry.last_modified.value = node.last_modified;
+		entry.hash.value		  = node.hash;
+		entry.options.value		  = node.options;
+		entry.dependents.value	  = psl::array<psl::string> {std::begin(node.dependents), std::end(node.dependents)};
+	}
+
+	serialization::serializer s;
+	format::container container;
+	s.serialize<serialization::encode_to_format>(graph, container);
+	if(!assembler::write_if_changed(file, container.to_string()))
+		assembler::log->error("failed to write the shader dependencies to: {}", file);
+}
+
+std::set<psl::string> shader::outdated_dependencies() {
+	// every known file is checked once, a change marks the file itself and, through the reverse edges, every shader
+	// that includes it as outdated.
+	std::set<psl::string> result;
+	for(auto& [path, node] : m_Dependencies) {
+		if(std::filesystem::exists(path)) {
+			auto const last_modified = std::filesystem::last_write_time(path).time_since_epoch().count();
+			if(last_modified == node.last_modified)
+				continue;
+
+			// the write time is only a cheap first check, when hashing the content decides
+			if(m_Hash && node.hash != 0) {
+				if(auto content = utility::platform::file::read(path);
+				   content && assembler::hash64(content.value()) == node.hash) {
+					++m_ValidationStats.rehashed;
+					node.last_modified = last_modified;
+					continue;
+				}
+			}
+		}
+		result.insert(path);
+		result.insert(std::begin(node.dependents), std::end(node.dependents));
+	}
+	return result;
+}
+
+void shader::record_dependencies(psl::string const& file, psl::string const& options) {
+	std::lock_guard lock {m_CacheMutex};
+	for(auto& [path, node] : m_Dependencies) node.dependents.erase(file);
+
+	psl::array<psl::string_view> stack {file};
+	std::set<psl::string_view> visited {file};
+	while(!stack.empty()) {
+		auto path = stack.back();
+		stack.pop_back();
+		auto it = m_Cache.find(psl::string {path});
+		if(it == std::end(m_Cache))
+			continue;
+
+		// shaders outside of this build that share a changed include can no longer trust their recorded state
+		auto& node		   = m_Dependencies[it->first];
+		auto const changed = (node.hash != 0 && it->second.hash != 0) ? node.hash != it->second.hash
+																	   : node.last_modified != it->second.last_modified;
+		if(changed) {
+			for(auto const& dependent : node.dependents) m_Dependencies[dependent].options.clear();
+		}
+		node.last_modified = it->second.last_modified;
+		node.hash		   = it->second.hash;
+		if(path != file)
+			node.dependents.insert(file);
+
+		for(auto const& include : it->second.includes) {
+			if(visited.insert(include.path).second)
+				stack.emplace_back(include.path);
+		}
+	}
+	m_Dependencies[file].options = options;
+}
+
 bool valid(assembler::pathstring const& path) {
 	auto const extension = path->substr(path->find_last_of('.'));
 	return (extension == (".vert") || extension == (".frag") || extension == (".tesc") || extension == (".geom") ||
@@ -304,17 +685,64 @@ void shader::on_generate(psl::cli::pack& pack) {
 	auto ofile		   = assembler::pathstring {pack["output"]->as<psl::string>().get()};
 	auto overwrite	   = pack["overwrite"]->as<bool>().get();
 	auto compiled_glsl = pack["compiled glsl"]->as<bool>().get();
-	auto optimize	   = pack["optimize"]->as<bool>().get();
 	m_Verbose		   = pack["verbose"]->as<bool>().get();
 	auto types		   = pack["types"]->as<std::vector<psl::string>>().get();
+	auto jobs		   = pack["jobs"]->as<size_t>().get();
+	auto incremental   = pack["incremental"]->as<bool>().get();
+	auto dependencies  = pack["dependencies"]->as<psl::string>().get();
+	m_Hash			   = pack["hash"]->as<bool>().get();
+	auto variants	   = pack["variants"]->as<psl::string>().get();
+	m_ActionCache.directory(pack["cache"]->as<psl::string>().get());
+	auto const writes = assembler::write_statistics();
+
+	auto optimize = tools::optimization_t::none;
+	if(pack["optimize size"]->as<bool>().get())
+		optimize = tools::optimization_t::size;
+	else if(pack["optimize"]->as<bool>().get())
+		optimize = tools::optimization_t::performance;
+
+	if(!load_variants(variants))
+		return;
 
 	auto files = assembler::get_files(ifile, ofile);
 
-	size_t success = 0;
-	for(auto const& file : files) {
+	// variants of a single shader get compiled concurrently as well, share the workers with the files
+	m_VariantJobs = std::max<size_t>(
+	  1u, assembler::resolve_jobs(jobs) / std::max<size_t>(1u, std::min(assembler::resolve_jobs(jobs), files.size())));
+
+	{
+		std::lock_guard lock {m_CacheMutex};
+		++m_Epoch;
+		m_ValidationStats = {};
+	}
+
+	std::set<psl::string> outdated {};
+	if(incremental) {
+		load_dependencies(dependencies);
+		outdated = outdated_dependencies();
+	}
+	auto const gles = std::find(std::begin(types), std::end(types), "gles") != std::end(types);
+	auto up_to_date = [this, &outdated, gles](
+						psl::string const& input, psl::string const& output_file, psl::string const& options) {
+		auto it = m_Dependencies.find(input);
+		return it != std::end(m_Dependencies) && it->second.options == options && !outdated.contains(input) &&
+			   outputs_exist(output_file, gles);
+	};
+	auto const joined_types = std::accumulate(
+	  std::begin(types), std::end(types), psl::string {}, [](psl::string result, psl::string const& type) {
+		  return (result.empty() ? type : std::move(result) + ", " + type);
+	  });
+
+	// every file is an independent job, the output of each job is buffered and printed in the order of `files`.
+	psl::array<psl::string> options(files.size());
+	psl::array<uint8_t> generated(files.size(), 0);
+	std::atomic<size_t> success = 0;
+	std::atomic<size_t> skipped = 0;
+	assembler::parallel_for(files.size(), jobs, [&](size_t index) {
+		auto const& file = files[index];
 		if(!valid(file.first)) {
 			assembler::log->info("skipping {0}", file.first.platform());
-			continue;
+			return;
 		}
 		psl::string_view output = file.second;
 		if(ofile->empty() || ifile->at(ifile->size() - 1) == '*') {
@@ -323,12 +751,41 @@ void shader::on_generate(psl::cli::pack& pack) {
 			}
 		}
 
+		auto const input	   = file.first.platform();
+		auto const output_file = assembler::pathstring {output}.platform();
+		options[index]		   = fmt::format(
+		  "{}|{}|{}|{}|{}", output_file, std::to_underlying(optimize), compiled_glsl, joined_types, m_VariantsHash);
+		if(incremental && !overwrite && up_to_date(input, output_file, options[index])) {
+			if(m_Verbose)
+				assembler::log->info("{0} is up to date", input);
+			++skipped;
+			return;
+		}
+
 		if(generate(file.first, output, compiled_glsl, optimize, types)) {
 			assembler::log->info("generated shaders for {0}", file.first.platform());
+			generated[index] = 1;
 			++success;
 		} else
 			assembler::log->error("failed to generate shaders for " + file.first.platform());
+	});
+
+	if(incremental) {
+		for(size_t i = 0; i < files.size(); ++i) {
+			if(generated[i])
+				record_dependencies(files[i].first.platform(), options[i]);
+		}
+		save_dependencies(dependencies);
 	}
 
-	assembler::log->info("generated {0} shaders\n", success);
+	assembler::log->info("generated {0} shaders\n", success.load());
+	if(skipped > 0)
+		assembler::log->info("skipped {0} shaders that were up to date\n", skipped.load());
+	if(m_ValidationStats.skipped > 0)
+		assembler::log->info("dependency validation skipped {0} already validated files, saving {1} stat calls\n",
+							 m_ValidationStats.skipped,
+							 m_ValidationStats.stats);
+	if(m_ValidationStats.rehashed > 0)
+		assembler::log->info("{0} files had a new write time but identical content\n", m_ValidationStats.rehashed);
+	assembler::log_write_statistics(writes);
 }
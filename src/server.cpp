@@ -0,0 +1,186 @@
+#include "server.h"
+#include "details/parallel.hpp"
+#include "psl/serialization/serializer.hpp"
+#include "psl/string_utils.hpp"
+#include "stdafx.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+#ifdef WIN32
+	#include <fcntl.h>
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+using namespace psl;
+
+namespace details {
+struct message_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << level << text;
+	}
+
+	static constexpr char const serialization_name[8] {"MESSAGE"};
+	psl::serialization::property<"LEVEL", psl::string> level;
+	psl::serialization::property<"TEXT", psl::string> text;
+};
+
+struct response_t {
+  public:
+	template <typename S>
+	void serialize(S& s) {
+		s << request << success << duration << messages;
+	}
+
+	static constexpr char const serialization_name[9] {"RESPONSE"};
+	psl::serialization::property<"REQUEST", uint64_t> request;	  // index of the request, starting from 0
+	psl::serialization::property<"SUCCESS", bool> success;
+	psl::serialization::property<"DURATION", uint64_t> duration;
+	psl::serialization::property<"MESSAGES", psl::array<message_t>> messages;
+};
+}	 // namespace details
+
+namespace {
+#ifdef WIN32
+int descriptor(FILE* file) {
+	return _fileno(file);
+}
+int duplicate(int fd) {
+	return _dup(fd);
+}
+int duplicate(int fd, int target) {
+	return _dup2(fd, target);
+}
+FILE* open_descriptor(int fd) {
+	return _fdopen(fd, "wb");
+}
+void close_descriptor(int fd) {
+	_close(fd);
+}
+#else
+int descriptor(FILE* file) {
+	return fileno(file);
+}
+int duplicate(int fd) {
+	return dup(fd);
+}
+int duplicate(int fd, int target) {
+	return dup2(fd, target);
+}
+FILE* open_descriptor(int fd) {
+	return fdopen(fd, "wb");
+}
+void close_descriptor(int fd) {
+	close(fd);
+}
+#endif
+}	 // namespace
+
+namespace assembler {
+void server::run() {
+#ifdef WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	// the responses get a duplicate of the real stdout, and stdout itself is pointed at stderr while the server runs,
+	// so nothing else (std::cout, or printf in glslang, tint and assimp) can corrupt the framing.
+	std::cout.flush();
+	std::fflush(stdout);
+	auto const stdout_fd = descriptor(stdout);
+	auto const saved_fd	 = duplicate(stdout_fd);
+	auto const output_fd = (saved_fd < 0) ? -1 : duplicate(saved_fd);
+	FILE* output		 = (output_fd < 0) ? nullptr : open_descriptor(output_fd);
+	if(!output || duplicate(descriptor(stderr), stdout_fd) < 0) {
+		assembler::log->error("ERROR: could not reserve stdout for the responses of the server");
+		if(output)
+			std::fclose(output);
+		else if(output_fd >= 0)
+			close_descriptor(output_fd);
+		if(saved_fd >= 0)
+			close_descriptor(saved_fd);
+		return;
+	}
+
+	auto previous  = assembler::log;
+	assembler::log = std::make_shared<spdlog::logger>("", std::make_shared<spdlog::sinks::stderr_color_sink_st>());
+	assembler::log->set_pattern("%v");
+	assembler::log->set_level(previous->level());
+	assembler::log->info("server started, waiting for requests on stdin");
+
+	while(auto request = read_request(std::cin)) {
+		auto const response = handle(request.value());
+		auto const header	= fmt::format("{}\n", response.size());
+		std::fwrite(header.data(), 1, header.size(), output);
+		std::fwrite(response.data(), 1, response.size(), output);
+		std::fflush(output);
+
+		if(m_Root["exit"]->as<bool>().get())
+			break;
+	}
+
+	assembler::log->info("server stopped after {} requests", m_Requests);
+	std::fclose(output);
+	std::cout.flush();
+	std::fflush(stdout);
+	duplicate(saved_fd, stdout_fd);
+	close_descriptor(saved_fd);
+	assembler::log = previous;
+}
+
+std::optional<psl::string8_t> server::read_request(std::istream& input) const {
+	size_t size {0};
+	if(!(input >> size) || input.get() != '\n')
+		return std::nullopt;
+
+	psl::string8_t request(size, '\0');
+	if(!input.read(request.data(), size)) {
+		assembler::log->error("ERROR: the request was announced as {} bytes, but the input ended early", size);
+		return std::nullopt;
+	}
+	return request;
+}
+
+psl::string8_t server::handle(psl::string8::view request) {
+	// every request logs into its own buffer, the messages are sent back as part of the response
+	auto sink	   = std::make_shared<buffered_sink>();
+	auto previous  = assembler::log;
+	assembler::log = std::make_shared<spdlog::logger>("", sink);
+	assembler::log->set_level(previous->level());
+
+	details::response_t response {};
+	response.request.value = m_Requests++;
+	response.success.value = false;
+
+	auto const start = std::chrono::high_resolution_clock::now();
+	try {
+		psl::array<psl::string_view> commands = psl::utility::string::split(request, ("|"));
+		response.success.value				  = m_Root.parse(commands);
+	} catch(std::exception const& e) {
+		assembler::log->error("exception happened while handling the request: {}", e.what());
+	} catch(...) {
+		assembler::log->error("unknown failure occurred while handling the request");
+	}
+	response.duration.value = std::chrono::duration_cast<std::chrono::microseconds>(
+								std::chrono::high_resolution_clock::now() - start)
+								.count();
+	assembler::log = previous;
+
+	for(auto const& [level, text] : sink->messages()) {
+		auto& message	   = response.messages.value.emplace_back();
+		auto const name	   = spdlog::level::to_string_view(level);
+		message.level.value = psl::string(name.data(), name.size());
+		message.text.value	= text;
+		response.success.value &= level < spdlog::level::err;
+	}
+
+	serialization::serializer s;
+	format::container container;
+	s.serialize<serialization::encode_to_format>(response, container);
+	return container.to_string();
+}
+}	 // namespace assembler
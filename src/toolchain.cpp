@@ -0,0 +1,21 @@
+#include "toolchain.h"
+#include "generators/meta.h"
+#include "generators/models.h"
+#include "generators/shader.h"
+#include "stdafx.h"
+
+using psl::cli::pack;
+using psl::cli::value;
+
+namespace assembler {
+toolchain::toolchain()
+	: m_Shader(std::make_unique<generators::shader>()), m_Models(std::make_unique<generators::models>()),
+	  m_Meta(std::make_unique<generators::meta>()),
+	  m_Generators {
+		value<pack> {"shader", "glsl to spir-v compiler", {"shader", "s"}, std::move(m_Shader->pack())},
+		value<pack> {"model", "model importer", {"models", "g"}, std::move(m_Models->pack())},
+		value<pack> {"library", "meta library generator", {"library", "l"}, m_Meta->library_pack()},
+		value<pack> {"meta", "meta file generator", {"meta", "m"}, m_Meta->meta_pack()}} {}
+
+toolchain::~toolchain() = default;
+}	 // namespace assembler